@@ -0,0 +1,72 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+
+namespace cocaine { namespace framework {
+
+/// The cancellation token allows to abandon asynchronous operations, which were started with it.
+///
+/// All copies of a token share the same state, so cancelling any of them cancels all operations
+/// the token was passed to. To abandon only some operations of a batch, start each of them with its
+/// own token, for example \sa when_any cancels only tokens of operations left pending.
+///
+/// \threadsafe
+class cancellation_token_t {
+public:
+    typedef std::function<void()> callback_type;
+    typedef std::uint64_t subscription_type;
+
+private:
+    class state_t;
+    std::shared_ptr<state_t> d;
+
+public:
+    /// Constructs a new not cancelled token.
+    cancellation_token_t();
+
+    /// Cancels the token, calling all callbacks subscribed.
+    ///
+    /// Subsequent calls have no effect.
+    void
+    cancel();
+
+    /// Checks whether the token has been cancelled.
+    bool
+    cancelled() const noexcept;
+
+    /// Subscribes the callback to be called once the token is cancelled.
+    ///
+    /// If the token has already been cancelled, calls the callback immediately.
+    ///
+    /// \returns the subscription id, which can be used to unsubscribe the callback.
+    subscription_type
+    subscribe(callback_type callback);
+
+    /// Unsubscribes the callback with the given subscription id.
+    ///
+    /// \note the callback may still be running after this call, if the token is being cancelled
+    /// concurrently.
+    void
+    unsubscribe(subscription_type id);
+};
+
+}} // namespace cocaine::framework
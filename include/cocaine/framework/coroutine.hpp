@@ -0,0 +1,184 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+/// C++20 coroutine support.
+///
+/// The library itself is built as C++11, so this header is header-only and it's enabled only when
+/// the including translation unit is compiled with coroutines support.
+///
+/// Futures become both awaitable and usable as coroutine return types:
+/// \code{.cpp}
+/// future<void>
+/// handle(worker::sender tx, worker::receiver rx) {
+///     auto chunk = co_await rx.recv();
+///     tx = co_await tx.write(*chunk);
+///     co_await tx.close();
+/// }
+///
+/// worker.on<worker::coroutine>("ping", &handle);
+/// \endcode
+///
+/// Since sender::send(), receiver::recv() and their worker counterparts return futures, they are
+/// awaitable directly. Awaiting an already ready future never suspends. Otherwise the coroutine is
+/// resumed using the default executor of the future, which usually means the thread that has set
+/// the value, or on the given scheduler with resume_on().
+///
+/// Coroutine handlers are registered in workers with the worker::coroutine tag, which is defined in
+/// "cocaine/framework/worker/coroutine.hpp". The coroutine runs on the executor thread until its
+/// first suspension and does not occupy it while waiting.
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include "cocaine/framework/forwards.hpp"
+#include "cocaine/framework/scheduler.hpp"
+
+namespace cocaine { namespace framework {
+
+namespace detail { namespace coroutine {
+
+/// Awaiter for a future, that resumes the coroutine using the given executor.
+///
+/// \internal
+template<class... Args>
+class awaiter {
+    framework::future<Args...> fr;
+    executor_t executor;
+
+    /// Resolves the race between the value being set and the coroutine being suspended, when the
+    /// future becomes ready after await_ready().
+    ///
+    /// The one who comes second is responsible for the resumption.
+    std::atomic<bool> suspended;
+
+public:
+    awaiter(framework::future<Args...>&& fr, executor_t executor) :
+        fr(std::move(fr)),
+        executor(std::move(executor)),
+        suspended(false)
+    {}
+
+    bool
+    await_ready() const {
+        return fr.ready();
+    }
+
+    bool
+    await_suspend(std::coroutine_handle<> handle) {
+        fr.when_ready(executor, [this, handle](framework::future<Args...>&) {
+            if (suspended.exchange(true)) {
+                handle.resume();
+            }
+        });
+
+        // If the callback has already been called, continue without suspension.
+        return !suspended.exchange(true);
+    }
+
+    decltype(std::declval<framework::future<Args...>&>().get())
+    await_resume() {
+        return fr.get();
+    }
+};
+
+/// Coroutine promise, that fulfils the returned future.
+///
+/// The coroutine starts eagerly, exactly like a regular function returning a future.
+///
+/// \internal
+template<class... Args>
+class promise_base {
+protected:
+    framework::promise<Args...> pr;
+
+public:
+    framework::future<Args...>
+    get_return_object() {
+        return pr.get_future();
+    }
+
+    std::suspend_never
+    initial_suspend() const noexcept {
+        return {};
+    }
+
+    std::suspend_never
+    final_suspend() const noexcept {
+        return {};
+    }
+
+    void
+    unhandled_exception() {
+        pr.set_exception(std::current_exception());
+    }
+};
+
+template<class T>
+class promise_type : public promise_base<T> {
+public:
+    template<class U>
+    void
+    return_value(U&& value) {
+        this->pr.set_value(std::forward<U>(value));
+    }
+};
+
+template<>
+class promise_type<void> : public promise_base<void> {
+public:
+    void
+    return_void() {
+        this->pr.set_value();
+    }
+};
+
+}} // namespace detail::coroutine
+
+/// Awaits the given future, resuming the coroutine using the default executor of the future.
+template<class... Args>
+detail::coroutine::awaiter<Args...>
+operator co_await(future<Args...>&& fr) {
+    auto executor = fr.get_default_executor();
+    return detail::coroutine::awaiter<Args...>(std::move(fr), std::move(executor));
+}
+
+/// Awaits the given future, resuming the coroutine on the given scheduler if the future is not
+/// ready yet.
+template<class... Args>
+detail::coroutine::awaiter<Args...>
+resume_on(scheduler_t& scheduler, future<Args...>&& fr) {
+    return detail::coroutine::awaiter<Args...>(std::move(fr), scheduler);
+}
+
+}} // namespace cocaine::framework
+
+namespace std {
+
+template<class T, class... Params>
+struct coroutine_traits<cocaine::framework::future<T>, Params...> {
+    typedef cocaine::framework::detail::coroutine::promise_type<T> promise_type;
+};
+
+} // namespace std
+
+#endif
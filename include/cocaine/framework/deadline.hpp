@@ -0,0 +1,63 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+
+namespace cocaine { namespace framework {
+
+/// Represents a point in time, after which an asynchronous operation is abandoned with the timed
+/// out error.
+///
+/// Deadlines are implicitly constructible from durations, which are counted from now, so both
+/// `rx.recv(std::chrono::seconds(1))` and `rx.recv(deadline)` work. Invocation methods take their
+/// arguments as a parameter pack, so there the deadline must be passed explicitly:
+/// \code{.cpp}
+/// service->invoke<io::storage::read>(deadline_t(std::chrono::seconds(1)), "collection", "key");
+/// \endcode
+class deadline_t {
+public:
+    typedef std::chrono::steady_clock clock_type;
+
+private:
+    clock_type::time_point value;
+
+public:
+    /// Constructs a deadline, which expires after the given timeout from now.
+    template<class Rep, class Period>
+    deadline_t(std::chrono::duration<Rep, Period> timeout) :
+        value(clock_type::now() + std::chrono::duration_cast<clock_type::duration>(timeout))
+    {}
+
+    /// Constructs a deadline, which expires at the given time point.
+    explicit
+    deadline_t(clock_type::time_point value) :
+        value(value)
+    {}
+
+    auto
+    time_point() const -> clock_type::time_point {
+        return value;
+    }
+
+    auto
+    expired() const -> bool {
+        return clock_type::now() >= value;
+    }
+};
+
+}} // namespace cocaine::framework
@@ -17,21 +17,30 @@
 #pragma once
 
 #include <cstdint>
-#include <unordered_map>
+#include <map>
+#include <memory>
+#include <vector>
 
 #include <boost/asio/ip/tcp.hpp>
 
+#include <asio/buffer.hpp>
 #include <asio/ip/tcp.hpp>
 
 #include <cocaine/common.hpp>
 #include <cocaine/locked_ptr.hpp>
-#include <cocaine/rpc/asio/transport.hpp>
 
+#include "cocaine/framework/cancellation.hpp"
+#include "cocaine/framework/deadline.hpp"
 #include "cocaine/framework/encoder.hpp"
 #include "cocaine/framework/forwards.hpp"
 #include "cocaine/framework/receiver.hpp"
 
+#include "cocaine/framework/detail/buffer.hpp"
+#include "cocaine/framework/detail/channel_map.hpp"
 #include "cocaine/framework/detail/decoder.hpp"
+#include "cocaine/framework/detail/push.hpp"
+#include "cocaine/framework/detail/timer_wheel.hpp"
+#include "cocaine/framework/detail/transport.hpp"
 
 namespace cocaine { namespace framework {
 
@@ -54,14 +63,32 @@ class basic_session_t:
     /// We use the pure ASIO internally, because Cocaine API uses and exports it.
     typedef asio::ip::tcp protocol_type;
     typedef protocol_type::socket socket_type;
-    typedef io::transport<protocol_type, io::encoder_t, detail::decoder_t> transport_type;
+    typedef detail::transport<protocol_type, detail::decoder_t> transport_type;
 
-    typedef std::unordered_map<
-        std::uint64_t,
-        std::shared_ptr<shared_state_t>
-    > channel_map_type;
+    typedef detail::push_t push_t;
+    typedef basic_receiver_t<basic_session_t> receiver_type;
 
-    class push_t;
+    typedef std::vector<push_t> queue_type;
+
+    /// Outbound queue.
+    ///
+    /// All messages pushed during a single event loop tick are gathered here and then flushed
+    /// using a single scatter/gather write operation.
+    ///
+    /// Spans are allocated without locking, so concurrent invocations may arrive here out of
+    /// order. Since the other side requires channel ids to grow monotonically, such invocations
+    /// are held until all preceding spans are admitted.
+    struct outbox_t {
+        queue_type queue;
+        /// Invocations waiting for preceding spans, null for spans that will never be written.
+        std::map<std::uint64_t, std::unique_ptr<push_t>> pending;
+        /// The next invocation span allowed to be queued.
+        std::uint64_t next;
+        /// Whether a flush is scheduled or a write operation is in progress.
+        bool flushing;
+
+        outbox_t() : next(1), flushing(false) {}
+    };
 
 public:
     typedef boost::asio::ip::tcp::endpoint endpoint_type;
@@ -91,12 +118,12 @@ private:
     decoded_message message;
 
     synchronized<std::shared_ptr<transport_type>> transport;
-    synchronized<channel_map_type> channels;
+    detail::channel_map_t channels;
+    synchronized<outbox_t> outbox;
+    detail::buffer_pool_t buffers;
 
     std::atomic<bool> hard_shutdown_;
 
-    std::mutex mutex;
-
 public:
     /// Constructs a disconnected session.
     ///
@@ -114,10 +141,18 @@ public:
     bool
     connected() const noexcept;
 
+    /// Returns the number of channels currently open, i.e. invocations in flight.
+    auto
+    inflight() const noexcept -> std::size_t;
+
     /// \threadsafe
     future<std::error_code>
     connect(const endpoint_type& endpoint);
 
+    /// Connects to the first reachable of the given endpoints, racing staggered attempts, so that
+    /// unreachable endpoints don't delay connecting to healthy ones for the whole TCP connect
+    /// timeout.
+    ///
     /// \threadsafe
     auto connect(const std::vector<endpoint_type>& endpoints) -> task<std::error_code>::future_type;
 
@@ -153,12 +188,48 @@ public:
     future<invoke_result>
     invoke(encode_callback_t encode_callback);
 
+    /// Sends an invocation event, encoding it directly into a pooled buffer.
+    ///
+    /// \threadsafe
+    future<invoke_result>
+    invoke(encode_ref_t encode);
+
+    /// Sends an invocation event, binding the channel created to the given cancellation token.
+    ///
+    /// Nothing is sent if the token has already been cancelled, the future returned throws the
+    /// operation aborted error instead.
+    ///
+    /// \threadsafe
+    future<invoke_result>
+    invoke(encode_ref_t encode, cancellation_token_t token);
+
+    /// Sends an invocation event, setting the deadline of the channel created.
+    ///
+    /// Nothing is sent if the deadline has already expired, the future returned throws the timed
+    /// out error instead.
+    ///
+    /// \threadsafe
+    future<invoke_result>
+    invoke(encode_ref_t encode, deadline_t deadline);
+
     /// TODO: Implement: invoke_mute - sends an invoke event without channel creation.
 
     /// Sends an event without creating a new channel.
+    ///
+    /// The message is queued and written together with all other messages pushed during the
+    /// current event loop tick.
     future<void>
     push(io::encoder_t::message_type&& message);
 
+    /// Sends an event into the channel with the given span, encoding it directly into a pooled
+    /// buffer.
+    future<void>
+    push(std::uint64_t span, encode_ref_t encode);
+
+    /// Returns the timer wheel, which expires deadlines of this session's channels.
+    auto
+    timers() -> detail::timer_wheel_t&;
+
     /*!
      * Unsubscribes a channel with the given span.
      *
@@ -169,7 +240,7 @@ public:
 private:
     /// Called on socket connect event.
     void
-    on_connect(const std::error_code& ec, promise<std::error_code> pr, std::unique_ptr<socket_type>& socket);
+    on_connect(const std::error_code& ec, promise<std::error_code> pr, std::unique_ptr<socket_type> socket);
 
     /// Called on socket read event.
     void
@@ -181,6 +252,44 @@ private:
 
     void
     pull(std::shared_ptr<transport_type> transport);
+
+    /// Queues the given message to be written with the next flush.
+    void
+    send(push_t&& push);
+
+    /// Creates a new channel and enqueues the invocation message, encoded by the given function
+    /// into the push object.
+    ///
+    /// The bind function is called with the channel receiver right after the channel is
+    /// registered.
+    template<class Encode, class Bind>
+    future<invoke_result>
+    invoke_with(Encode encode, Bind bind);
+
+    /// Queues an invocation message in the span order.
+    ///
+    /// Passing null push releases the span without writing anything, which must be done for each
+    /// allocated span that is not going to be sent, otherwise all subsequent invocations stall.
+    void
+    enqueue(std::uint64_t span, push_t* push);
+
+    /// Schedules a flush if there is something to write and no flush is pending.
+    ///
+    /// \return true if a flush should be posted to the event loop.
+    /// \warning call only with the outbox lock held.
+    static
+    bool
+    schedule(outbox_t& outbox);
+
+    /// Writes all queued messages using a single scatter/gather operation.
+    ///
+    /// \warning call only from the event loop thread.
+    void
+    flush();
+
+    /// Called on scatter/gather write completion.
+    void
+    on_write(const std::error_code& ec, std::shared_ptr<queue_type> batch, std::shared_ptr<transport_type> transport);
 };
 
 }} // namespace cocaine::framework
@@ -0,0 +1,149 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <asio/buffer.hpp>
+
+#include <cocaine/locked_ptr.hpp>
+
+namespace cocaine { namespace framework { namespace detail {
+
+/// Growable output buffer, which is used as a MessagePack packer stream.
+///
+/// Large writes from the payloads shared with the buffer are not copied, but referenced in place
+/// instead, keeping the payload alive until the buffer is cleared. The content is then written
+/// using a single vectored operation.
+///
+/// \internal
+class buffer_t {
+    /// Referenced payload fragment, which follows the given number of bytes of the storage.
+    struct segment_t {
+        std::size_t offset;
+        const char* data;
+        std::size_t size;
+    };
+
+    std::vector<char> storage;
+    std::vector<segment_t> segments;
+    std::vector<std::shared_ptr<const std::string>> owners;
+
+public:
+    /// The minimum size of a write to be referenced instead of copied.
+    static const std::size_t share_threshold = 16 * 1024;
+
+    /// Allows large writes from the given payload to be referenced instead of copied.
+    void
+    share(std::shared_ptr<const std::string> payload) {
+        owners.push_back(std::move(payload));
+    }
+
+    void
+    write(const char* data, std::size_t size) {
+        if (size >= share_threshold && shared(data, size)) {
+            segments.push_back(segment_t{storage.size(), data, size});
+        } else {
+            storage.insert(storage.end(), data, data + size);
+        }
+    }
+
+    /// Returns the total content size.
+    auto
+    size() const noexcept -> std::size_t {
+        std::size_t result = storage.size();
+        for (const auto& segment : segments) {
+            result += segment.size;
+        }
+
+        return result;
+    }
+
+    auto
+    capacity() const noexcept -> std::size_t {
+        return storage.capacity();
+    }
+
+    /// Appends the content as a sequence of buffers.
+    void
+    gather(std::vector<asio::const_buffer>& sequence) const {
+        std::size_t offset = 0;
+        for (const auto& segment : segments) {
+            if (segment.offset > offset) {
+                sequence.emplace_back(storage.data() + offset, segment.offset - offset);
+            }
+
+            sequence.emplace_back(segment.data, segment.size);
+            offset = segment.offset;
+        }
+
+        if (storage.size() > offset) {
+            sequence.emplace_back(storage.data() + offset, storage.size() - offset);
+        }
+    }
+
+    /// Discards the content and releases shared payloads, keeping the allocated memory.
+    void
+    clear() noexcept {
+        storage.clear();
+        segments.clear();
+        owners.clear();
+    }
+
+private:
+    bool
+    shared(const char* data, std::size_t size) const noexcept {
+        for (const auto& owner : owners) {
+            if (data >= owner->data() && data + size <= owner->data() + owner->size()) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+/// Pool of output buffers.
+///
+/// Buffers are handed back after their content has been written, so encoding small messages in
+/// the steady state reuses already allocated memory.
+///
+/// \internal
+/// \threadsafe
+class buffer_pool_t {
+    synchronized<std::vector<buffer_t>> buffers;
+
+public:
+    /// The maximum number of free buffers kept for reuse.
+    static const std::size_t capacity = 64;
+
+    /// The maximum capacity of a buffer to be kept for reuse, larger ones are freed.
+    static const std::size_t max_buffer_capacity = 64 * 1024;
+
+    /// Returns an empty buffer, reusing a released one if possible.
+    auto
+    acquire() -> buffer_t;
+
+    /// Clears the given buffer and returns it into the pool.
+    void
+    release(buffer_t&& buffer) noexcept;
+};
+
+}}} // namespace cocaine::framework::detail
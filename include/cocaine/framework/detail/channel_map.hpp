@@ -0,0 +1,86 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <cocaine/locked_ptr.hpp>
+
+#include "cocaine/framework/forwards.hpp"
+
+namespace cocaine { namespace framework { namespace detail {
+
+/// Maps channel spans to their shared states.
+///
+/// The map is split into independently locked shards, so operations on different spans contend
+/// only when they fall into the same shard. Since spans are allocated sequentially, consecutive
+/// channels are spread evenly between shards.
+///
+/// \internal
+/// \threadsafe
+class channel_map_t {
+public:
+    typedef std::shared_ptr<shared_state_t> value_type;
+
+    static const std::size_t shards = 16;
+
+private:
+    typedef std::unordered_map<std::uint64_t, value_type> shard_type;
+
+    std::array<synchronized<shard_type>, shards> data;
+    std::atomic<std::size_t> count;
+
+public:
+    channel_map_t();
+
+    /// Registers a channel with the given span.
+    void
+    insert(std::uint64_t span, value_type state);
+
+    /// Returns the channel state with the given span or nullptr if there is no such channel.
+    auto
+    find(std::uint64_t span) -> value_type;
+
+    /// Unregisters a channel with the given span, returning true if it was registered.
+    auto
+    erase(std::uint64_t span) -> bool;
+
+    /// Unregisters all channels, returning their states.
+    ///
+    /// Shards are drained one after another, each atomically, so a channel inserted concurrently
+    /// into an already drained shard stays registered.
+    auto
+    drain() -> std::vector<value_type>;
+
+    auto
+    empty() const noexcept -> bool;
+
+    /// Returns the number of registered channels.
+    auto
+    size() const noexcept -> std::size_t;
+
+private:
+    auto
+    shard(std::uint64_t span) -> synchronized<shard_type>&;
+};
+
+}}} // namespace cocaine::framework::detail
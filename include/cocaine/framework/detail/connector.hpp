@@ -0,0 +1,119 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+#include <asio/ip/tcp.hpp>
+#include <asio/steady_timer.hpp>
+
+#include "cocaine/framework/util/future/unique_function.hpp"
+
+#include "cocaine/framework/detail/forwards.hpp"
+
+namespace cocaine {
+
+namespace framework {
+
+namespace detail {
+
+/// Connects a socket to the first reachable of the given endpoints, racing connection attempts in
+/// the "happy eyeballs" manner (RFC 8305).
+///
+/// Endpoints are interleaved by address family, keeping the family of the first one preferred.
+/// Attempts are started one after another either after the given delay or right after the
+/// previous attempt fails, while earlier attempts keep running. The first established connection
+/// wins and all other attempts are cancelled, so a blackholed endpoint costs only the delay
+/// instead of the whole TCP connect timeout.
+///
+/// \internal
+/// \threadsafe
+class connector_t : public std::enable_shared_from_this<connector_t> {
+public:
+    typedef asio::ip::tcp protocol_type;
+    typedef protocol_type::socket socket_type;
+    typedef protocol_type::endpoint endpoint_type;
+
+    typedef unique_function<void(const std::error_code&, std::unique_ptr<socket_type>)> handler_type;
+
+    /// The default delay between attempts, as recommended by RFC 8305.
+    static const std::chrono::milliseconds default_delay;
+
+private:
+    loop_t& loop;
+    const std::vector<endpoint_type> endpoints;
+    const std::chrono::milliseconds delay;
+
+    handler_type handler;
+
+    /// Sockets of attempts started, indexed the same as endpoints. Failed attempts are reset.
+    std::vector<std::unique_ptr<socket_type>> sockets;
+    asio::steady_timer timer;
+
+    /// The index of the endpoint to try next.
+    std::size_t next;
+    /// The number of attempts in progress.
+    std::size_t pending;
+    /// The error of the most recently failed attempt.
+    std::error_code error;
+    bool done;
+
+    std::mutex mutex;
+
+public:
+    connector_t(loop_t& loop,
+                std::vector<endpoint_type> endpoints,
+                std::chrono::milliseconds delay = default_delay);
+
+    /// Starts connecting.
+    ///
+    /// The handler is called exactly once from the event loop thread with either the connected
+    /// socket or the error of the last failed attempt.
+    ///
+    /// \warning must be called only once.
+    void
+    connect(handler_type handler);
+
+private:
+    /// Starts the next attempt, then schedules the one after it.
+    ///
+    /// \warning call only with the lock held.
+    void
+    start();
+
+    void
+    on_connect(const std::error_code& ec, std::size_t id);
+
+    void
+    on_timer(const std::error_code& ec, std::size_t id);
+
+    /// Cancels all attempts in progress.
+    ///
+    /// \warning call only with the lock held.
+    void
+    cancel();
+};
+
+} // namespace detail
+
+} // namespace framework
+
+} // namespace cocaine
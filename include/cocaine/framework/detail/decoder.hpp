@@ -17,27 +17,98 @@
 #pragma once
 
 #include <stddef.h>
+#include <cstdint>
 #include <system_error>
+#include <vector>
 
 #include <cocaine/hpack/header.hpp>
 
 #include <msgpack.hpp>
 
+#include "cocaine/framework/detail/slab.hpp"
+
 namespace cocaine { namespace framework {
 
 class decoded_message;
 
 namespace detail {
 
+/// Incremental MessagePack frame boundary scanner.
+///
+/// Walks over element headers without unpacking them and skips string, binary and extension
+/// payloads entirely, remembering its position between calls. This way each byte of a frame
+/// received in several pieces is examined at most once, no matter how many pieces there are.
+///
+/// \internal
+class scanner_t {
+    /// The maximum frame size allowed.
+    size_t limit;
+    /// Offset of the next element header relative to the frame beginning.
+    size_t offset;
+    /// Number of elements left in each of enclosing containers.
+    std::vector<std::uint64_t> stack;
+    /// Whether the top level element has been fully scanned, except possibly its payload.
+    bool done;
+    /// Number of bytes that are known to be missing to make progress.
+    size_t missing;
+
+public:
+    explicit
+    scanner_t(size_t limit);
+
+    /// Continues scanning the frame starting at the given data.
+    ///
+    /// The data must start at the same frame beginning as in previous calls, but may reside at
+    /// another address.
+    ///
+    /// \returns the frame size if the frame is complete, resetting the scanner for the next
+    /// frame. Otherwise sets the error code either to insufficient bytes, to parse error or to
+    /// frame format error if the frame is known to exceed the limit, and returns zero.
+    size_t scan(const char* data, size_t size, std::error_code& ec);
+
+    /// Returns the number of bytes that are known to be required to make progress, after the
+    /// last scan call has reported insufficient bytes.
+    size_t remaining() const noexcept;
+
+private:
+    /// Marks the current element as complete, unwinding finished containers.
+    void complete();
+};
+
 /// The decoder represents streaming MessagePack decoding.
 ///
-/// \note this class does explicit memory copying to the message_type object.
+/// Frame boundaries are found incrementally by the scanner, so each frame is unpacked exactly
+/// once, after it has been completely received.
+///
+/// \note decoded messages reference their data in place, sharing the ownership of the slab it
+/// was read into. Frames no larger than the copy threshold are copied into the message zone
+/// instead, so small long-living messages do not keep entire slabs alive.
 /// \internal
 struct decoder_t {
     typedef decoded_message message_type;
+
+    /// The maximum size of frames, that are copied out of the slab.
+    static const size_t copy_threshold = 1024;
+
+    /// The maximum size of frames accepted.
+    ///
+    /// Larger frames are rejected as soon as their headers are scanned, so a peer can't force an
+    /// allocation of arbitrary size by announcing a huge payload.
+    static const size_t max_frame_size = 256 * 1024 * 1024;
+
     hpack::header_table_t header_table;
+    scanner_t scanner;
+
+    decoder_t();
+
+    /// Decodes a single message from the given region of the slab.
+    ///
+    /// The region must start at the beginning of the frame, that has been passed to the previous
+    /// call, unless that call has decoded it completely.
+    size_t decode(const slab_ptr& slab, const char* data, size_t size, message_type& message, std::error_code& ec);
 
-    size_t decode(const char* data, size_t size, message_type& message, std::error_code& ec);
+    /// Returns the number of bytes that are known to be required to decode the current frame.
+    size_t remaining() const noexcept;
 };
 
 } // namespace detail
@@ -0,0 +1,118 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cocaine/locked_ptr.hpp>
+
+#include "cocaine/framework/forwards.hpp"
+
+#include "cocaine/framework/detail/resolver.hpp"
+
+namespace cocaine {
+
+namespace framework {
+
+namespace detail {
+
+/// Receives locator updates of a single service.
+///
+/// \internal
+class watcher_t {
+public:
+    virtual ~watcher_t() {}
+
+    /// Returns the name of the service watched.
+    virtual
+    auto
+    name() const -> const std::string& = 0;
+
+    /// Called each time the locator announces the service, whose endpoints are empty if it has
+    /// gone.
+    ///
+    /// \note called from the event loop thread, so it must neither block nor throw.
+    virtual
+    void
+    update(const resolver_t::result_t& result) = 0;
+};
+
+/// Subscribes to the locator's routing stream and passes service updates to watchers.
+///
+/// The subscription runs over its own locator session, which is reconnected after a delay each
+/// time it breaks, as the locator's stream is infinite.
+///
+/// \internal
+/// \threadsafe
+class discovery_t : public std::enable_shared_from_this<discovery_t> {
+public:
+    typedef resolver_t::endpoint_type endpoint_type;
+    typedef resolver_t::result_t result_type;
+
+    /// The delay before resubscribing after the subscription breaks.
+    static const std::chrono::milliseconds retry_interval;
+
+private:
+    scheduler_t& scheduler;
+    const std::vector<endpoint_type> endpoints;
+
+    /// The identity, which the locator tracks this subscriber by, and the locator session, which
+    /// are both set once the subscription is started.
+    std::string uuid;
+    std::shared_ptr<session_t> locator;
+
+    std::atomic<bool> running;
+
+    synchronized<std::vector<std::weak_ptr<watcher_t>>> watchers;
+
+public:
+    discovery_t(scheduler_t& scheduler, std::vector<endpoint_type> endpoints);
+
+    ~discovery_t();
+
+    /// Registers the given watcher, which is dropped automatically after being destroyed.
+    ///
+    /// Watchers are kept even if the subscription is not started, so that they are notified once
+    /// it is.
+    void
+    attach(std::weak_ptr<watcher_t> watcher);
+
+    /// Starts the subscription unless it is already running.
+    void
+    start();
+
+    /// Passes the given service update to all watchers of the service.
+    void
+    update(const std::string& name, const result_type& result);
+
+private:
+    void
+    subscribe();
+
+    void
+    resubscribe();
+};
+
+} // namespace detail
+
+} // namespace framework
+
+} // namespace cocaine
@@ -16,12 +16,42 @@
 
 #pragma once
 
+#include <memory>
+
+#include "cocaine/framework/util/future/unique_function.hpp"
+
 #include "cocaine/framework/detail/forwards.hpp"
+#include "cocaine/framework/detail/timer_wheel.hpp"
 
 namespace cocaine {
 
 namespace framework {
 
+namespace detail {
+
+/// Adapts a move-only closure to the asio completion handler requirements.
+///
+/// Asio requires posted handlers to be copy constructible, so the closure is held by a shared
+/// pointer. Copies share the same closure, which is invoked at most once anyway.
+///
+/// \internal
+class closure_handler_t {
+    std::shared_ptr<unique_function<void()>> fn;
+
+public:
+    explicit
+    closure_handler_t(unique_function<void()> fn) :
+        fn(std::make_shared<unique_function<void()>>(std::move(fn)))
+    {}
+
+    void
+    operator()() {
+        (*fn)();
+    }
+};
+
+} // namespace detail
+
 /// \internal
 struct event_loop_t {
     typedef detail::loop_t loop_type;
@@ -29,14 +59,19 @@ struct event_loop_t {
     loop_type& loop;
     loop_type& userloop;
 
-    explicit event_loop_t(loop_type& loop) noexcept :
+    /// Expires deadlines of all sessions running on the IO loop.
+    detail::timer_wheel_t timers;
+
+    explicit event_loop_t(loop_type& loop) :
         loop(loop),
-        userloop(loop)
+        userloop(loop),
+        timers(loop)
     {}
 
-    event_loop_t(loop_type& ioloop, loop_type& userloop) noexcept :
+    event_loop_t(loop_type& ioloop, loop_type& userloop) :
         loop(ioloop),
-        userloop(userloop)
+        userloop(userloop),
+        timers(ioloop)
     {}
 };
 
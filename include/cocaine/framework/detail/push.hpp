@@ -0,0 +1,53 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <asio/buffer.hpp>
+
+#include <cocaine/rpc/asio/encoder.hpp>
+
+#include "cocaine/framework/forwards.hpp"
+
+#include "cocaine/framework/detail/buffer.hpp"
+
+namespace cocaine { namespace framework { namespace detail {
+
+/// Pending outgoing message with its completion promise.
+///
+/// \internal
+struct push_t {
+    /// Pooled buffer with the encoded message.
+    buffer_t buffer;
+    /// Message encoded elsewhere, in which case the buffer is empty.
+    std::unique_ptr<io::encoder_t::message_type> message;
+    promise<void> pr;
+
+    /// Appends the message content as a sequence of buffers.
+    void
+    gather(std::vector<asio::const_buffer>& sequence) const {
+        if (message) {
+            sequence.emplace_back(message->data(), message->size());
+        } else {
+            buffer.gather(sequence);
+        }
+    }
+};
+
+}}} // namespace cocaine::framework::detail
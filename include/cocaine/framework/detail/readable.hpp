@@ -0,0 +1,158 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <system_error>
+
+#include <asio/buffer.hpp>
+
+#include <cocaine/errors.hpp>
+
+#include "cocaine/framework/detail/slab.hpp"
+
+namespace cocaine { namespace framework { namespace detail {
+
+/// Buffered stream reader, which reads directly into pooled slabs.
+///
+/// Unlike the Cocaine one, it passes the slab to the decoder, allowing decoded messages to
+/// reference their payload in place instead of copying it. The only copying left is moving the
+/// prefix of a partially received frame into a fresh slab when the current one runs out of space.
+///
+/// \internal
+template<class Protocol, class Decoder>
+class readable_stream:
+    public std::enable_shared_from_this<readable_stream<Protocol, Decoder>>
+{
+public:
+    typedef typename Protocol::socket channel_type;
+    typedef Decoder decoder_type;
+    typedef typename decoder_type::message_type message_type;
+
+    typedef std::function<void(const std::error_code&)> handler_type;
+
+private:
+    /// The minimum free space in the slab worth issuing a read operation for.
+    static const std::size_t min_read_size = 4096;
+
+    const std::shared_ptr<channel_type> channel;
+
+    slab_ptr slab;
+
+    /// Number of bytes read into the current slab.
+    std::size_t rd_offset;
+    /// Number of bytes already decoded from the current slab.
+    std::size_t rx_offset;
+
+    decoder_type decoder;
+
+public:
+    explicit
+    readable_stream(std::shared_ptr<channel_type> channel) :
+        channel(std::move(channel)),
+        slab(slab_t::acquire()),
+        rd_offset(0),
+        rx_offset(0)
+    {}
+
+    /// Decodes the next message from the buffered data, reading more from the channel if
+    /// required, then posts the handler.
+    ///
+    /// \warning the message reference should be valid until the handler is called.
+    template<class Handler>
+    void
+    read(message_type& message, Handler handler) {
+        const std::size_t pending = rd_offset - rx_offset;
+
+        std::error_code ec;
+        const std::size_t offset = decoder.decode(slab, slab->data() + rx_offset, pending, message, ec);
+
+        if (ec == cocaine::error::insufficient_bytes) {
+            prepare(pending, decoder.remaining());
+
+            channel->async_read_some(
+                asio::buffer(slab->data() + rd_offset, slab->capacity() - rd_offset),
+                std::bind(&readable_stream::fill, this->shared_from_this(),
+                    std::ref(message), handler_type(std::move(handler)),
+                    std::placeholders::_1, std::placeholders::_2
+                )
+            );
+
+            return;
+        }
+
+        rx_offset += offset;
+        channel->get_io_service().post(std::bind(handler, ec));
+    }
+
+private:
+    void
+    fill(message_type& message, handler_type handler, const std::error_code& ec, std::size_t size) {
+        if (ec) {
+            handler(ec);
+            return;
+        }
+
+        rd_offset += size;
+        read(message, std::move(handler));
+    }
+
+    /// Makes sure that the current slab has enough free space for the next read operation,
+    /// preserving the given number of pending bytes of a partially received frame.
+    ///
+    /// The number of bytes the decoder knows to be missing is used to size the new slab, so even
+    /// a large frame is moved at most once.
+    void
+    prepare(std::size_t pending, std::size_t missing) {
+        if (pending == 0 && (!slab->unique() || slab->capacity() != slab_t::default_capacity)) {
+            // Either decoded messages still reference the current slab or it has been grown for a
+            // single large frame. Either way there is nothing to move, so just start a new one.
+            slab = slab_t::acquire();
+            rd_offset = rx_offset = 0;
+            return;
+        }
+
+        if (pending == 0) {
+            rd_offset = rx_offset = 0;
+        }
+
+        if (slab->capacity() - rd_offset >= min_read_size) {
+            return;
+        }
+
+        const std::size_t capacity = std::max(slab_t::default_capacity, pending + std::max(missing, min_read_size));
+
+        if (slab->unique() && capacity <= slab->capacity()) {
+            std::memmove(slab->data(), slab->data() + rx_offset, pending);
+        } else {
+            auto next = slab_t::acquire(capacity);
+            std::memcpy(next->data(), slab->data() + rx_offset, pending);
+            slab = std::move(next);
+        }
+
+        rd_offset = pending;
+        rx_offset = 0;
+    }
+};
+
+template<class Protocol, class Decoder>
+const std::size_t readable_stream<Protocol, Decoder>::min_read_size;
+
+}}} // namespace cocaine::framework::detail
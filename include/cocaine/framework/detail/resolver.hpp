@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <chrono>
+#include <deque>
+#include <mutex>
 #include <unordered_map>
 
 #include <boost/asio/ip/tcp.hpp>
@@ -29,6 +32,13 @@ namespace framework {
 namespace detail {
 
 /*!
+ * Resolves services through the locator.
+ *
+ * Resolves go through a long-lived locator session, which multiplexes them as separate channels.
+ * Resolvers of all services created by a single service manager share the session owned by the
+ * manager, while other resolvers create a private one on the first resolve. The session is
+ * connected lazily on the first resolve and reconnected the same way after it breaks.
+ *
  * \reentrant
  */
 class resolver_t {
@@ -43,6 +53,8 @@ public:
 private:
     scheduler_t& scheduler;
     std::vector<endpoint_type> endpoints_;
+    std::shared_ptr<session_t> locator_;
+    mutable std::mutex mutex;
 
 public:
     /*!
@@ -53,30 +65,77 @@ public:
     ~resolver_t();
 
     std::vector<endpoint_type> endpoints() const;
+
+    /*!
+     * \note drops the locator session given, if any, as it connects to other endpoints.
+     * \warning must not be called concurrently with resolve().
+     */
     void endpoints(std::vector<endpoint_type> endpoints);
 
+    /// Makes resolves go through the given locator session, which connects to the endpoints of
+    /// this resolver.
+    ///
+    /// \warning must not be called concurrently with resolve().
+    void locator(std::shared_ptr<session_t> locator);
+
     // No queue.
     auto resolve(std::string name) -> task<result_t>::future_type;
 };
 
 /// Manages with queue.
+///
+/// Also caches resolved results for the given TTL, so that reconnecting services don't have to
+/// ask the locator each time. After the TTL expires the stale result is still served, while it
+/// is being refreshed in the background, and also after the refresh fails, until it's
+/// invalidated.
+///
 /// \threadsafe
 class serialized_resolver_t : public std::enable_shared_from_this<serialized_resolver_t> {
 public:
     typedef resolver_t::result_t result_type;
     typedef resolver_t::endpoint_type endpoint_type;
+    typedef std::chrono::steady_clock clock_type;
+
+    /// The default time to live of cached results.
+    static const clock_type::duration default_ttl;
 
 private:
+    struct entry_t {
+        result_type result;
+        clock_type::time_point expires;
+    };
+
     resolver_t resolver;
     scheduler_t& scheduler;
+    clock_type::duration ttl_;
+    std::unordered_map<std::string, entry_t> cache;
     std::unordered_map<std::string, std::deque<task<result_type>::promise_type>> inprogress;
     std::mutex mutex;
 
 public:
     serialized_resolver_t(std::vector<endpoint_type> endpoints, scheduler_t& scheduler);
 
+    /// Makes resolves go through the given shared locator session.
+    ///
+    /// \warning must not be called concurrently with resolve().
+    void locator(std::shared_ptr<session_t> locator);
+
+    /// Sets the time to live of cached results. Zero disables caching.
+    ///
+    /// Results cached so far expire using the previous TTL.
+    void ttl(clock_type::duration ttl);
+
     auto resolve(std::string name) -> task<result_type>::future_type;
 
+    /// Drops the cached result for the given name, if any.
+    ///
+    /// Usually called when endpoints resolved can't be connected to.
+    void invalidate(const std::string& name);
+
+    /// Replaces the cached result for the given name with the one announced by the locator, or
+    /// drops it if the service has gone.
+    void update(const std::string& name, const result_type& result);
+
     result_type
     notify_all(task<result_type>::future_move_type future, std::string name);
 };
@@ -16,12 +16,19 @@
 
 #pragma once
 
-#include <queue>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+#include <boost/optional/optional.hpp>
 
 #include "cocaine/framework/forwards.hpp"
 #include "cocaine/framework/message.hpp"
 
 #include "cocaine/framework/detail/decoder.hpp"
+#include "cocaine/framework/detail/spsc_queue.hpp"
 
 #include <cocaine/trace/trace.hpp>
 
@@ -29,28 +36,125 @@ namespace cocaine {
 
 namespace framework {
 
+/// Channel state, which buffers incoming messages until they are received.
+///
+/// Messages are put by the session read loop only and received by a single consumer, so they are
+/// passed through a lock-free SPSC queue. Promises of receivers waiting for a message are owned
+/// by whoever holds the busy flag of the state word: the consumer arming a new waiter, or the
+/// producer or a canceller completing armed ones. The producer never waits for that flag: if it
+/// is held, the producer marks the state dirty and the holder rechecks it before leaving.
+///
+/// Alternatively the state can be switched into the push mode, in which messages are passed to
+/// the subscriber directly by the holder instead of completing waiters.
+///
 /// \internal
+/// \threadsafe put() must be called from a single thread, get() must not be called concurrently.
 class shared_state_t {
 public:
     typedef decoded_message value_type;
 
 private:
-    std::queue<value_type> queue;
-    std::queue<task<value_type>::promise_type> await;
+    typedef task<value_type>::promise_type promise_type;
+
+    /// State word flags.
+    enum flags_t: int {
+        /// Someone owns the waiters.
+        busy  = 1,
+        /// There are waiters.
+        armed = 2,
+        /// Either a message or an error has arrived while the waiters were owned.
+        dirty = 4
+    };
+
+    /// Broken state word values.
+    enum status_t: int { intact, breaking, broken };
+
+    std::atomic<int> state;
+    std::atomic<int> status;
+
+    /// Valid when status is equal to broken.
+    std::error_code error;
 
-    boost::optional<std::error_code> broken;
+    detail::spsc_queue<value_type> queue;
 
-    std::mutex mutex;
+    /// Waiters are guarded by the busy flag. Usually there is at most one, so the oldest is stored
+    /// inline, while the rest are kept in order of arrival.
+    boost::optional<promise_type> waiter;
+    std::vector<promise_type> waiters;
+
+    /// Push mode handlers, guarded by the busy flag either.
+    struct subscriber_t;
+    std::shared_ptr<subscriber_t> subscriber;
 
 public:
     shared_state_t() :
+        state(0),
+        status(intact),
         trace(trace_t::current())
     {}
+
+    /// Puts the given message into the state, completing the oldest waiter if any.
+    ///
+    /// \note must be called from the session read loop only.
     void put(value_type&& message);
+
+    /// Breaks the state with the given error, if not broken yet.
     void put(const std::error_code& ec);
+
     auto get() -> task<value_type>::future_type;
 
+    /// Moves buffered messages into the given vector until it holds the given number of them,
+    /// without waiting for more.
+    ///
+    /// Nothing is moved if the state is broken or there are waiters, which are to be completed
+    /// with these messages first.
+    void take(std::vector<value_type>& messages, std::size_t max);
+
+    /// Breaks the state with the given error, dropping all buffered messages.
+    ///
+    /// Messages put after this call are dropped either, buffered ones are destroyed on the next
+    /// get() call or with the state itself.
+    void cancel(const std::error_code& ec);
+
+    /// Switches the state into the push mode, passing buffered and further messages to the given
+    /// message handler and the error, if any, to the error handler.
+    ///
+    /// Handlers are called sequentially either on the given executor or directly by the thread
+    /// which has put the message. On the executor messages are delivered in batches by a single
+    /// posted task at a time, so handlers neither overlap nor reorder even if the executor is
+    /// multithreaded. Both of them are destroyed after the error is handled.
+    ///
+    /// \pre there are no waiters and get() is never called afterwards.
+    void subscribe(executor_t executor,
+                   std::function<void(value_type&&)> on_message,
+                   std::function<void(const std::error_code&)> on_error);
+
     trace_t trace;
+
+private:
+    /// Marks the state dirty, taking the busy flag if there are waiters to be completed.
+    void notify();
+
+    /// Spins until the busy flag is taken.
+    void lock();
+
+    /// Completes waiters with buffered messages or with the error, then releases the busy flag.
+    ///
+    /// \pre the busy flag is held by the caller.
+    void unlock();
+
+    /// Passes buffered messages or the error to the subscriber.
+    ///
+    /// \pre the busy flag is held by the caller.
+    void dispatch();
+
+    /// Moves buffered messages or the error into the subscriber mailbox, posting a task to drain
+    /// it unless one is already posted.
+    ///
+    /// \pre the busy flag is held by the caller.
+    void post();
+
+    auto is_broken() const -> bool;
 };
 
 } // namespace framework
@@ -0,0 +1,76 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include <boost/intrusive_ptr.hpp>
+
+namespace cocaine { namespace framework { namespace detail {
+
+class slab_t;
+
+typedef boost::intrusive_ptr<slab_t> slab_ptr;
+
+void intrusive_ptr_add_ref(slab_t* slab) noexcept;
+void intrusive_ptr_release(slab_t* slab) noexcept;
+
+/// Reference counted read buffer.
+///
+/// Incoming data is read directly into slabs and decoded messages keep a reference to the slab
+/// they were decoded from instead of copying their payload. Released slabs of the default
+/// capacity are returned into the process-wide pool for further reuse.
+///
+/// \internal
+/// \threadsafe
+class slab_t {
+    std::atomic<std::size_t> refs;
+    const std::size_t capacity_;
+    std::unique_ptr<char[]> data_;
+
+public:
+    /// The capacity of pooled slabs.
+    static const std::size_t default_capacity = 64 * 1024;
+
+    /// Returns a slab with at least the given capacity.
+    ///
+    /// Slabs of the default capacity are taken from the pool when possible.
+    static
+    auto
+    acquire(std::size_t capacity = default_capacity) -> slab_ptr;
+
+    auto
+    data() noexcept -> char*;
+
+    auto
+    capacity() const noexcept -> std::size_t;
+
+    /// Checks whether the caller holds the only reference to this slab.
+    auto
+    unique() const noexcept -> bool;
+
+private:
+    explicit
+    slab_t(std::size_t capacity);
+
+    friend void intrusive_ptr_add_ref(slab_t* slab) noexcept;
+    friend void intrusive_ptr_release(slab_t* slab) noexcept;
+};
+
+}}} // namespace cocaine::framework::detail
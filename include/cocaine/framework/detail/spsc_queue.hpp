@@ -0,0 +1,175 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include <boost/optional/optional.hpp>
+
+namespace cocaine { namespace framework { namespace detail {
+
+/// Unbounded single-producer/single-consumer queue.
+///
+/// Values are stored in fixed-size blocks linked into a list: the producer constructs values at
+/// the tail block and publishes them with a release store, the consumer destroys them at the
+/// head one. The first block is embedded into the queue itself and a drained block is recycled
+/// through a single spare slot, so neither a short-lived nor a steady stream allocates.
+///
+/// \internal
+/// \threadsafe for a single producer and a single consumer, which may be different threads.
+/// The consumer role may be passed to another thread, provided that the handover synchronizes.
+template<class T, std::size_t N = 8>
+class spsc_queue {
+    struct block_t {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type slots[N];
+
+        /// Number of constructed values, written by the producer only.
+        std::atomic<std::size_t> size;
+        std::atomic<block_t*> next;
+
+        block_t() :
+            size(0),
+            next(nullptr)
+        {}
+
+        auto
+        at(std::size_t id) -> T* {
+            return reinterpret_cast<T*>(&slots[id]);
+        }
+    };
+
+    block_t inline_block;
+
+    /// Consumer side.
+    block_t* head;
+    std::size_t position;
+
+    /// Producer side.
+    block_t* tail;
+
+    /// Drained block, waiting to be reused by the producer.
+    std::atomic<block_t*> spare;
+
+public:
+    spsc_queue() :
+        head(&inline_block),
+        position(0),
+        tail(&inline_block),
+        spare(nullptr)
+    {}
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    ~spsc_queue() {
+        for (auto block = head; block; block = next(block)) {
+            const auto size = block->size.load(std::memory_order_acquire);
+            for (auto id = block == head ? position : 0; id < size; ++id) {
+                block->at(id)->~T();
+            }
+        }
+
+        release(spare.load(std::memory_order_acquire));
+    }
+
+    /// Checks whether there are values to be popped.
+    ///
+    /// \note must be called by the consumer.
+    auto
+    empty() const -> bool {
+        if (position < N) {
+            return position == head->size.load(std::memory_order_acquire);
+        }
+
+        // A block is linked only after its first value has been constructed.
+        return head->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    /// \note must be called by the producer.
+    void
+    push(T value) {
+        auto size = tail->size.load(std::memory_order_relaxed);
+
+        if (size < N) {
+            new (tail->at(size)) T(std::move(value));
+            tail->size.store(size + 1, std::memory_order_release);
+            return;
+        }
+
+        auto block = spare.exchange(nullptr, std::memory_order_acquire);
+        if (block) {
+            block->size.store(0, std::memory_order_relaxed);
+            block->next.store(nullptr, std::memory_order_relaxed);
+        } else {
+            block = new block_t;
+        }
+
+        new (block->at(0)) T(std::move(value));
+        block->size.store(1, std::memory_order_relaxed);
+        tail->next.store(block, std::memory_order_release);
+        tail = block;
+    }
+
+    /// \note must be called by the consumer.
+    auto
+    pop() -> boost::optional<T> {
+        if (position == N) {
+            auto block = head->next.load(std::memory_order_acquire);
+            if (block == nullptr) {
+                return boost::none;
+            }
+
+            recycle(head);
+            head = block;
+            position = 0;
+        }
+
+        if (position == head->size.load(std::memory_order_acquire)) {
+            return boost::none;
+        }
+
+        auto value = head->at(position++);
+        boost::optional<T> result(std::move(*value));
+        value->~T();
+        return result;
+    }
+
+private:
+    auto
+    next(block_t* block) -> block_t* {
+        auto result = block->next.load(std::memory_order_acquire);
+        release(block);
+        return result;
+    }
+
+    void
+    recycle(block_t* block) {
+        release(spare.exchange(block, std::memory_order_acq_rel));
+    }
+
+    void
+    release(block_t* block) {
+        if (block != &inline_block) {
+            delete block;
+        }
+    }
+};
+
+}}} // namespace cocaine::framework::detail
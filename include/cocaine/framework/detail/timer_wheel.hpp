@@ -0,0 +1,125 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "cocaine/framework/util/future/unique_function.hpp"
+
+#include "cocaine/framework/detail/forwards.hpp"
+
+namespace cocaine { namespace framework { namespace detail {
+
+/// A scheduled timer.
+///
+/// \internal
+struct wheel_timer_t {
+    typedef unique_function<void()> callback_type;
+
+    /// The expiration tick.
+    std::uint64_t expiry;
+    /// The callback, touched only by the thread which schedules it and then by the wheel.
+    callback_type callback;
+    /// Whether the timer has either expired or been cancelled.
+    std::atomic<bool> done;
+    /// The number of pending timers of the wheel, decremented by whoever marks the timer done.
+    std::shared_ptr<std::atomic<std::size_t>> pending;
+
+    wheel_timer_t(callback_type callback, std::shared_ptr<std::atomic<std::size_t>> pending) :
+        expiry(0),
+        callback(std::move(callback)),
+        done(false),
+        pending(std::move(pending))
+    {}
+
+    /// Cancels the timer, preventing its callback from being called.
+    ///
+    /// \returns false if the timer has already expired or been cancelled.
+    bool
+    cancel() noexcept {
+        return complete();
+    }
+
+    /// Marks the timer done.
+    ///
+    /// \returns false if the timer has already expired or been cancelled.
+    bool
+    complete() noexcept {
+        if (done.exchange(true)) {
+            return false;
+        }
+
+        --*pending;
+        return true;
+    }
+};
+
+/// The hierarchical timing wheel, which expires any number of timers using a single asio timer.
+///
+/// Timers are hashed by their expiration tick into several levels of slots, each level covering
+/// the whole range of the previous one with a single slot. Both scheduling and cancelling are
+/// O(1): cancelled timers are marked and then dropped when the wheel reaches their slot. Timers of
+/// the upper levels cascade down as the wheel turns, so each timer is moved at most once per
+/// level.
+///
+/// The wheel ticks only while there are pending timers, i.e. neither expired nor cancelled ones.
+/// Once the last one is gone, cancelled timers left in slots are dropped at once and the wheel
+/// stops, so that cancelled far-future timers keep neither the event loop busy nor it running.
+///
+/// \internal
+/// \threadsafe
+class timer_wheel_t {
+public:
+    typedef std::chrono::steady_clock clock_type;
+    typedef std::shared_ptr<wheel_timer_t> handle_type;
+
+    /// Number of bits of the tick covered by each level.
+    static const std::size_t bits = 6;
+    static const std::size_t slots = 1 << bits;
+    static const std::size_t levels = 4;
+
+private:
+    class impl;
+    std::shared_ptr<impl> d;
+
+public:
+    /// Constructs a wheel, which expires timers on the given event loop with the given resolution.
+    ///
+    /// With the default 10 ms resolution four levels cover about 46 hours, longer timers are
+    /// rehashed each time the last level turns.
+    explicit
+    timer_wheel_t(loop_t& loop, clock_type::duration resolution = std::chrono::milliseconds(10));
+
+    ~timer_wheel_t();
+
+    /// Schedules the callback to be called from the event loop thread at the given time point.
+    ///
+    /// Timers are rounded up to the wheel resolution, so they never expire earlier.
+    ///
+    /// \returns the timer handle, which can be used to cancel the timer.
+    auto
+    schedule(clock_type::time_point deadline, wheel_timer_t::callback_type callback) -> handle_type;
+
+    /// Returns the number of pending timers in the wheel, i.e. neither expired nor cancelled.
+    auto
+    size() const -> std::size_t;
+};
+
+}}} // namespace cocaine::framework::detail
@@ -0,0 +1,45 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <memory>
+
+#include "cocaine/framework/detail/readable.hpp"
+
+namespace cocaine { namespace framework { namespace detail {
+
+/// Socket transport with the zero-copy reader.
+///
+/// Writes are performed by the sessions directly on the socket, gathering all queued messages.
+///
+/// \internal
+template<class Protocol, class Decoder>
+struct transport {
+    typedef Protocol protocol_type;
+    typedef typename protocol_type::socket socket_type;
+
+    const std::shared_ptr<socket_type> socket;
+    const std::shared_ptr<readable_stream<protocol_type, Decoder>> reader;
+
+    explicit
+    transport(std::unique_ptr<socket_type> socket_) :
+        socket(std::move(socket_)),
+        reader(std::make_shared<readable_stream<protocol_type, Decoder>>(socket))
+    {}
+};
+
+}}} // namespace cocaine::framework::detail
@@ -63,8 +63,8 @@ public:
         pool.join_all();
     }
 
-    void operator()(std::function<void()> fn) {
-        loop.post(std::move(fn));
+    void operator()(unique_function<void()> fn) {
+        loop.post(closure_handler_t(std::move(fn)));
     }
 
 private:
@@ -20,6 +20,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include <asio/local/stream_protocol.hpp>
 
@@ -27,13 +28,16 @@
 #include <cocaine/forwards.hpp>
 #include <cocaine/idl/rpc.hpp>
 #include <cocaine/locked_ptr.hpp>
-#include <cocaine/rpc/asio/transport.hpp>
 
 #include "cocaine/framework/encoder.hpp"
 #include "cocaine/framework/message.hpp"
 #include "cocaine/framework/worker/dispatch.hpp"
 
+#include "cocaine/framework/detail/buffer.hpp"
 #include "cocaine/framework/detail/decoder.hpp"
+#include "cocaine/framework/detail/push.hpp"
+#include "cocaine/framework/detail/timer_wheel.hpp"
+#include "cocaine/framework/detail/transport.hpp"
 
 namespace cocaine {
 
@@ -46,8 +50,6 @@ namespace framework {
 class worker_session_t:
     public std::enable_shared_from_this<worker_session_t>
 {
-    template<class> class push_t;
-
 public:
     typedef asio::local::stream_protocol protocol_type;
     typedef protocol_type::endpoint endpoint_type;
@@ -64,9 +66,19 @@ private:
     detail::decoder_t::message_type message;
 
     /// Underlying transport.
-    typedef io::transport<protocol_type, io::encoder_t, detail::decoder_t> transport_type;
+    typedef detail::transport<protocol_type, detail::decoder_t> transport_type;
     synchronized<std::unique_ptr<transport_type>> transport;
 
+    /// Pool of buffers for outgoing messages.
+    detail::buffer_pool_t buffers;
+
+    /// Messages queued since the last write started, which are written together using a single
+    /// vectored operation.
+    ///
+    /// \note accessed from the event loop thread only.
+    std::vector<detail::push_t> outbox;
+    bool writing;
+
     std::atomic<std::uint64_t> counter;
     synchronized<std::map<std::uint64_t, std::shared_ptr<shared_state_t>>> channels;
 
@@ -94,10 +106,30 @@ public:
     future<void>
     push(io::encoder_t::message_type&& message);
 
+    /// Sends an event into the channel with the given span, encoding it directly into a pooled
+    /// buffer.
+    future<void>
+    push(std::uint64_t span, encode_ref_t encode);
+
     void
     revoke(std::uint64_t span);
 
+    /// Returns the timer wheel, which expires deadlines of this session's channels.
+    auto
+    timers() -> detail::timer_wheel_t&;
+
 private:
+    /// Queues the given message into the outbox.
+    ///
+    /// \note must be called from the event loop thread.
+    void enqueue(std::shared_ptr<detail::push_t> push);
+
+    /// Writes all queued messages unless there is a write in progress.
+    void flush();
+
+    /// Completes the written messages, then writes the ones queued meanwhile.
+    void on_write(const std::error_code& ec, std::shared_ptr<std::vector<detail::push_t>> batch);
+
     /// Handle incoming protocol message.
     void on_read(const std::error_code& ec);
 
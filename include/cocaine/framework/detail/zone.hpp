@@ -0,0 +1,40 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <memory>
+
+#include <msgpack/zone.hpp>
+
+namespace cocaine { namespace framework { namespace detail {
+
+/// Returns an empty zone, reusing a previously released one if possible.
+///
+/// \threadsafe
+auto
+acquire_zone() -> std::unique_ptr<msgpack::zone>;
+
+/// Clears the given zone and returns it into the process-wide pool.
+///
+/// A cleared zone keeps its initial chunk, so unpacking a small message into a reused zone
+/// allocates nothing.
+///
+/// \threadsafe
+void
+release_zone(std::unique_ptr<msgpack::zone> zone) noexcept;
+
+}}} // namespace cocaine::framework::detail
@@ -20,12 +20,126 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+
 #include <cocaine/rpc/asio/encoder.hpp>
+#include <cocaine/utility.hpp>
 
 namespace cocaine { namespace framework {
 
 typedef std::function<io::encoder_t::message_type(std::uint64_t)> encode_callback_t;
 
+namespace detail {
+
+class buffer_t;
+
+/// MessagePack packer stream, which appends to the output buffer.
+///
+/// Keeps the buffer type opaque for the public headers, which are installed without the detail
+/// ones.
+///
+/// \internal
+class buffer_stream_t {
+    buffer_t& buffer;
+
+public:
+    explicit
+    buffer_stream_t(buffer_t& buffer) noexcept :
+        buffer(buffer)
+    {}
+
+    void
+    write(const char* data, std::size_t size);
+};
+
+/// Encodes an event with the given arguments directly into the given packer stream.
+///
+/// \internal
+template<class Event, class Stream, class... Args>
+void
+encode(Stream& stream, std::uint64_t span, const Args&... args) {
+    msgpack::packer<Stream> packer(stream);
+    packer.pack_array(3);
+    packer.pack_uint64(span);
+    packer.pack_uint64(io::event_traits<Event>::id);
+
+    io::type_traits<
+        typename io::event_traits<Event>::argument_type
+    >::pack(packer, args...);
+}
+
+} // namespace detail
+
+/// Non-owning reference to an event with its arguments, which are encoded on demand, when the
+/// channel id becomes known.
+///
+/// Unlike encode_callback_t it is just a plain function pointer with an argument pointer, so
+/// constructing and calling it never allocates.
+///
+/// \warning the reference is valid only while the arguments tuple it was made from is alive.
+class encode_ref_t {
+    typedef void(*function_type)(detail::buffer_t& buffer, std::uint64_t span, const void* args);
+
+    function_type function;
+    const void* args;
+
+    /// Payload to be referenced by the encoded message instead of being copied, if any.
+    const std::shared_ptr<const std::string>* payload;
+
+    template<class Event, class Tuple, class IndexSequence>
+    struct helper;
+
+    template<class Event, class Tuple, std::size_t... Index>
+    struct helper<Event, Tuple, index_sequence<Index...>> {
+        static
+        void
+        apply(detail::buffer_t& buffer, std::uint64_t span, const void* args) {
+            const auto& tuple = *static_cast<const Tuple*>(args);
+            detail::buffer_stream_t stream(buffer);
+            detail::encode<Event>(stream, span, std::get<Index>(tuple)...);
+        }
+    };
+
+    encode_ref_t(function_type function, const void* args) :
+        function(function),
+        args(args),
+        payload(nullptr)
+    {}
+
+public:
+    /// The minimum size of a payload worth sharing with the output buffer instead of copying it.
+    static const std::size_t share_threshold = 16 * 1024;
+
+    /// Makes a reference to the given event, whose arguments are stored in the tuple.
+    template<class Event, class Tuple>
+    static
+    encode_ref_t
+    make(const Tuple& args) {
+        typedef typename make_index_sequence<std::tuple_size<Tuple>::value>::type index_type;
+        return encode_ref_t(&helper<Event, Tuple, index_type>::apply, &args);
+    }
+
+    /// Marks the given payload, which one of the arguments refers to, to be shared with the
+    /// output buffer instead of being copied into it.
+    ///
+    /// \warning the reference is valid only while the given pointer is alive.
+    encode_ref_t
+    share(const std::shared_ptr<const std::string>& payload) const {
+        encode_ref_t result(*this);
+        result.payload = &payload;
+        return result;
+    }
+
+    /// Encodes the referenced event into the given output buffer.
+    void
+    operator()(detail::buffer_t& buffer, std::uint64_t span) const;
+};
+
 template<class Event, class... Args>
 static
 io::encoder_t::message_type
@@ -36,6 +36,8 @@ namespace cocaine {
 
         class scheduler_t;
 
+        class cancellation_token_t;
+
         /// \internal
         class shared_state_t;
 
@@ -68,9 +68,24 @@ public:
     template<class T>
     service<T>
     create(std::string name) {
-        return service<T>(logger(), std::move(name), endpoints(), next());
+        service<T> result(logger(), std::move(name), endpoints(), next());
+        attach(result);
+        return result;
     }
 
+    /// Subscribes to the Locator's routing stream, which announces services as soon as their
+    /// endpoints change, e.g. during rolling restarts.
+    ///
+    /// On each announcement cached resolve results are refreshed and connected services created
+    /// by this manager are moved to the new endpoints in the background, instead of failing
+    /// requests and reconnecting afterwards. Channels opened so far remain on the old connection
+    /// until they are done.
+    ///
+    /// The subscription is restored automatically after the Locator connection breaks. Calling
+    /// this method more than once has no effect.
+    void
+    watch();
+
     /// Returns a shared pointer to the associated logger service.
     std::shared_ptr<service<io::log_tag>>
     logger() const;
@@ -92,6 +107,11 @@ private:
 
     scheduler_t&
     next();
+
+    /// Makes the given service resolve through the Locator session shared by this manager and
+    /// registers it to receive the Locator announcements.
+    void
+    attach(basic_service_t& service);
 };
 
 }} // namespace cocaine::framework
@@ -16,26 +16,83 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <stddef.h>
+#include <vector>
 
+#include <boost/intrusive_ptr.hpp>
 #include <boost/none_t.hpp>
 #include <boost/optional.hpp>
 
 #include <msgpack.hpp>
 
 #include <cocaine/hpack/header.hpp>
+#include <cocaine/hpack/static_table.hpp>
 
 namespace msgpack { struct object; }
 
 namespace cocaine {
 namespace framework {
 
+namespace detail {
+
+/// Opaque reference counted read buffer, which is defined internally.
+class slab_t;
+
+typedef boost::intrusive_ptr<slab_t> slab_ptr;
+
+void intrusive_ptr_add_ref(slab_t* slab) noexcept;
+void intrusive_ptr_release(slab_t* slab) noexcept;
+
+/// Maps well-known tracing headers to their slots in the message header index, other headers are
+/// looked up linearly.
+template<class Header>
+struct tracing_header {
+    static const int value = -1;
+};
+
+template<>
+struct tracing_header<hpack::headers::trace_id<>> {
+    static const int value = 0;
+};
+
+template<>
+struct tracing_header<hpack::headers::span_id<>> {
+    static const int value = 1;
+};
+
+template<>
+struct tracing_header<hpack::headers::parent_id<>> {
+    static const int value = 2;
+};
+
+} // namespace detail
+
 /// The decoded message class represents movable unpacked MessagePack payload with internal storage.
+///
+/// Span, type and arguments are extracted once on construction and stored inline, so the message
+/// can be moved around and inspected without additional heap allocations or conversions.
 class decoded_message {
-    class inner_t;
-    std::unique_ptr<inner_t> d;
+    std::uint64_t span_;
+    std::uint64_t type_;
+
+    /// Points to the arguments object, which lives in the zone.
+    const msgpack::object* args_;
+
+    std::unique_ptr<msgpack::zone> zone;
+    std::vector<char> storage;
+    detail::slab_ptr slab;
+
+    /// Headers are decoded on the first access if they were not required to be decoded eagerly,
+    /// until then this points to their raw representation in the zone.
+    mutable const msgpack::object* packed;
+    mutable std::vector<hpack::header_t> headers;
+
+    /// Positions of well-known tracing headers, built on the first lookup of any of them.
+    mutable bool indexed;
+    mutable std::array<std::size_t, 3> tracing;
 
 public:
     /// Constructs a null-initialized message object.
@@ -51,6 +108,18 @@ public:
 
     decoded_message(msgpack::object, std::unique_ptr<msgpack::zone> zone, std::vector<char> storage, std::vector<hpack::header_t> headers);
 
+    /// Constructs a message object from msgpack object, which data is stored in place in the given
+    /// slab, sharing its ownership.
+    decoded_message(msgpack::object, std::unique_ptr<msgpack::zone> zone, detail::slab_ptr slab, std::vector<hpack::header_t> headers);
+
+    /// Constructs a message object from msgpack object, which data is stored in place in the given
+    /// slab, postponing the headers decoding until they are accessed.
+    ///
+    /// \pre all headers, if any, should be literals that are not stored into the dynamic table,
+    /// because the decoding is performed without the table. Malformed headers are reported on the
+    /// first access.
+    decoded_message(msgpack::object, std::unique_ptr<msgpack::zone> zone, detail::slab_ptr slab);
+
     ~decoded_message();
 
     // TODO: Noexcept?
@@ -58,22 +127,41 @@ public:
     decoded_message& operator=(decoded_message&& other);
 
     /// Returns the message span id.
-    auto span() const -> std::uint64_t;
+    auto span() const noexcept -> std::uint64_t {
+        return span_;
+    }
 
     /// Returns the message type.
-    auto type() const -> std::uint64_t;
+    auto type() const noexcept -> std::uint64_t {
+        return type_;
+    }
 
     /// Returns the object representation of message arguments.
-    auto args() const -> const msgpack::object&;
+    auto args() const noexcept -> const msgpack::object& {
+        return *args_;
+    }
 
-    auto meta() const noexcept -> const std::vector<hpack::header_t>&;
+    /// Returns the message headers, decoding them if required.
+    ///
+    /// \throws std::system_error with frame format error if postponed headers are malformed. The
+    /// headers are left empty then.
+    /// \note as any other accessor, it is not thread-safe.
+    auto meta() const -> const std::vector<hpack::header_t>&;
 
     template<class Header>
     boost::optional<hpack::header_t>
     get_header() const {
+        if (detail::tracing_header<Header>::value >= 0) {
+            return lookup(detail::tracing_header<Header>::value);
+        }
+
         return boost::optional<hpack::header_t>(hpack::header::find_first(meta(), Header::name()));
     }
 
+private:
+    /// Returns the well-known tracing header with the given slot using the header index.
+    auto lookup(std::size_t slot) const -> boost::optional<hpack::header_t>;
+
 };
 
 } // namespace framework
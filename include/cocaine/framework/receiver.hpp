@@ -19,23 +19,34 @@
 #include <array>
 #include <cstdint>
 #include <functional>
+#include <vector>
 
 #include <boost/assert.hpp>
+#include <boost/optional.hpp>
 #include <boost/mpl/size.hpp>
 
 #include <cocaine/rpc/tags.hpp>
 
 #include <cocaine/trace/trace.hpp>
 
+#include "cocaine/framework/cancellation.hpp"
+#include "cocaine/framework/deadline.hpp"
 #include "cocaine/framework/forwards.hpp"
 #include "cocaine/framework/message.hpp"
 #include "cocaine/framework/receiver.inl.hpp"
+#include "cocaine/framework/subscriber.hpp"
 #include "cocaine/framework/trace.hpp"
 
 namespace cocaine {
 
 namespace framework {
 
+namespace detail {
+
+struct wheel_timer_t;
+
+} // namespace detail
+
 /// The basic receiver provides an interface to extract incoming MessagePack'ed payloads from the
 /// session.
 template<class Session>
@@ -48,6 +59,13 @@ private:
     std::shared_ptr<session_type> session;
     std::shared_ptr<shared_state_t> state;
 
+    /// The token this receiver is bound to, if any, and the subscription id.
+    boost::optional<cancellation_token_t> token;
+    std::uint64_t subscription;
+
+    /// The channel deadline timer, if any.
+    std::shared_ptr<detail::wheel_timer_t> timer;
+
 public:
     basic_receiver_t(std::uint64_t id, std::shared_ptr<session_type> session, std::shared_ptr<shared_state_t> state);
 
@@ -55,8 +73,53 @@ public:
 
     /// Returns a future with a decoded message received from the session.
     ///
-    /// This future may throw std::system_error on any network failure.
+    /// This future may throw std::system_error on any network failure or with the operation
+    /// aborted error if the channel has been cancelled.
     auto recv() -> task<decoded_message>::future_type;
+
+    /// Returns a future with a decoded message received from the session.
+    ///
+    /// If no message arrives before the given deadline, the channel is revoked and the future
+    /// throws std::system_error with the timed out error.
+    auto recv(deadline_t deadline) -> task<decoded_message>::future_type;
+
+    /// Returns a future with all messages buffered so far, but no more than the given number.
+    ///
+    /// If there are no buffered messages, the future becomes ready when the next one arrives,
+    /// taking also ones arrived with it. Thus the vector is never empty.
+    ///
+    /// \pre max > 0.
+    auto recv_many(std::size_t max) -> task<std::vector<decoded_message>>::future_type;
+
+    /// Cancels the channel, revoking its span and dropping all messages buffered.
+    ///
+    /// Pending and further receive operations fail with the operation aborted error.
+    void cancel();
+
+    /// Binds the channel to the given token, so that it will be cancelled with the token.
+    ///
+    /// \note the receiver can be bound to a single token only.
+    void bind(cancellation_token_t token);
+
+    /// Sets the deadline of the whole channel.
+    ///
+    /// Unless the receiver is destroyed before the deadline, the channel is revoked and pending and
+    /// further receive operations fail with the timed out error.
+    ///
+    /// \note the deadline can be set only once.
+    void expire(deadline_t deadline);
+
+    /// Switches the channel into the push mode, passing buffered and further messages to the
+    /// given message handler and the error, if any, to the error handler.
+    ///
+    /// Handlers are called sequentially either on the given executor or directly from the I/O
+    /// thread if it is empty.
+    ///
+    /// \warning recv() must not be called after this call.
+    void subscribe(executor_t executor,
+                   std::function<void(decoded_message&&)> on_message,
+                   std::function<void(const std::error_code&)> on_error);
+
     cocaine::trace_t get_trace() const;
 };
 
@@ -69,9 +132,14 @@ public:
 
 private:
     typedef typename detail::result_of<receiver<T, session_type>>::type result_type;
-    typedef std::function<result_type(std::shared_ptr<basic_receiver_t<session_type>>, const msgpack::object&)> unpacker_type;
+    typedef result_type(*unpacker_type)(std::shared_ptr<basic_receiver_t<session_type>>, const msgpack::object&);
+    typedef detail::to_array<
+        typename result_type::types,
+        detail::unpacker_factory<session_type, unpacker_type>
+    > unpackers_factory;
 
-    static const std::unordered_map<std::uint64_t, unpacker_type> unpackers;
+    /// Unpackers indexed by message type id.
+    static const typename unpackers_factory::result_type unpackers;
 
     std::shared_ptr<basic_receiver_t<session_type>> d;
 
@@ -123,25 +191,42 @@ public:
         auto d = std::move(this->d);
         auto future = d->recv();
 
+        return chain(std::move(future), std::move(d));
+    }
+
+    /// Performs receive asynchronous operation, which fails with the timed out error and revokes
+    /// the channel unless the next message arrives before the given deadline.
+    ///
+    /// \warning the current receiver will be invalidated after this call.
+    auto recv(deadline_t deadline) -> typename task<typename from_receiver<T, Session>::result_type>::future_type {
+        BOOST_ASSERT(this->d);
+
+        auto d = std::move(this->d);
+        auto future = d->recv(deadline);
+
+        return chain(std::move(future), std::move(d));
+    }
+
+private:
+    static
+    typename task<typename from_receiver<T, Session>::result_type>::future_type
+    chain(task<decoded_message>::future_type future, std::shared_ptr<basic_receiver_t<session_type>> d) {
         trace_t::restore_scope_t scope(d->get_trace());
         return future
             .then(trace_t::bind(&receiver::convert, std::placeholders::_1, d));
     }
 
-private:
     static inline
     typename from_receiver<T, Session>::result_type
     convert(task<decoded_message>::future_move_type future, std::shared_ptr<basic_receiver_t<session_type>> d) {
         const auto message = future.get();
         const auto id = message.type();
 
-        auto it = unpackers.find(id);
-
-        if (it == std::end(unpackers)) {
+        if (id >= unpackers.size()) {
             throw std::runtime_error("invalid protocol");
         }
 
-        auto result = it->second(std::move(d), message.args());
+        auto result = unpackers[id](std::move(d), message.args());
         return from_receiver<T, Session>::transform(result);
     }
 };
@@ -167,12 +252,29 @@ public:
     typedef io::streaming_tag<T> tag_type;
     typedef Session session_type;
 
+    /// The type of chunks.
+    typedef typename from_receiver<tag_type, Session>::result_type::value_type value_type;
+
 private:
     typedef typename detail::variant_of<tag_type>::type result_type;
-    typedef std::function<result_type(const msgpack::object&)> unpacker_type;
-    typedef std::unordered_map<std::uint64_t, unpacker_type> unpackers_type;
+    typedef result_type(*unpacker_type)(const msgpack::object&);
+    typedef detail::to_array<
+        typename result_type::types,
+        detail::unpacker_factory<session_type, unpacker_type>
+    > unpackers_factory;
+
+    /// Unpackers indexed by message type id.
+    static const typename unpackers_factory::result_type unpackers;
+
+    /// State of the callback-driven subscription.
+    struct subscription_t {
+        stream_handlers<value_type> handlers;
 
-    static const unpackers_type unpackers;
+        /// Keeps the channel alive until it is either closed or failed.
+        std::shared_ptr<basic_receiver_t<session_type>> d;
+
+        trace_t trace;
+    };
 
     std::shared_ptr<basic_receiver_t<session_type>> d;
 
@@ -201,20 +303,132 @@ public:
             .then(trace_t::bind(&receiver::convert, std::placeholders::_1, d));
     }
 
+    /// Performs receive asynchronous operation, which fails with the timed out error and revokes
+    /// the channel unless the next chunk arrives before the given deadline.
+    auto recv(deadline_t deadline) -> typename task<typename from_receiver<tag_type, Session>::result_type>::future_type {
+        auto future = d->recv(deadline);
+        return future
+            .then(trace_t::bind(&receiver::convert, std::placeholders::_1, d));
+    }
+
+    /// Performs receive asynchronous operation, extracting all chunks buffered so far, but no more
+    /// than the given number, or the next one if there are no buffered chunks.
+    ///
+    /// \returns a future, which contains the non-empty vector of optional values of streaming
+    /// type, or the exception on any system error. Only the last value can be none, indicating
+    /// that the other side has closed the stream. If any of chunks received is an error, the
+    /// future throws it, dropping the rest.
+    ///
+    /// For example:
+    ///     recv_many(max) -> future<vector<optional<T>>> | throw.
+    auto recv_many(std::size_t max) -> typename task<std::vector<typename from_receiver<tag_type, Session>::result_type>>::future_type {
+        auto future = d->recv_many(max);
+        return future
+            .then(trace_t::bind(&receiver::convert_many, std::placeholders::_1, d));
+    }
+
+    /// Starts building a callback-driven subscription with the given chunk handler.
+    ///
+    /// Unlike recv() it does not create a future for each chunk, passing them to handlers right
+    /// after they are read, so prefer it for long streams.
+    ///
+    /// For example:
+    ///     rx.on_chunk(fn).on_error(fn).on_close(fn).subscribe(executor).
+    ///
+    /// \warning recv() must not be called after the subscription has been started.
+    auto on_chunk(std::function<void(value_type)> fn) -> subscriber<value_type> {
+        auto d = this->d;
+        return subscriber<value_type>([d](executor_t executor, stream_handlers<value_type> handlers) {
+            auto subscription = std::make_shared<subscription_t>(subscription_t {
+                std::move(handlers), d, d->get_trace()
+            });
+
+            d->subscribe(std::move(executor), [subscription](decoded_message&& message) {
+                receiver::dispatch(*subscription, message);
+            }, [subscription](const std::error_code& ec) {
+                receiver::fail(*subscription, std::make_exception_ptr(std::system_error(ec)));
+            });
+        }, std::move(fn));
+    }
+
 private:
+    static
+    void
+    dispatch(subscription_t& subscription, const decoded_message& message) {
+        if (!subscription.d) {
+            return;
+        }
+
+        trace_t::restore_scope_t scope(subscription.trace);
+
+        boost::optional<value_type> chunk;
+        try {
+            chunk = unpack(message);
+        } catch (...) {
+            fail(subscription, std::current_exception());
+            return;
+        }
+
+        if (chunk) {
+            if (subscription.handlers.chunk) {
+                subscription.handlers.chunk(std::move(*chunk));
+            }
+        } else {
+            // The channel is revoked after the close handler is called.
+            auto d = std::move(subscription.d);
+
+            if (subscription.handlers.close) {
+                subscription.handlers.close();
+            }
+        }
+    }
+
+    static
+    void
+    fail(subscription_t& subscription, std::exception_ptr error) {
+        if (!subscription.d) {
+            return;
+        }
+
+        trace_t::restore_scope_t scope(subscription.trace);
+        auto d = std::move(subscription.d);
+
+        if (subscription.handlers.error) {
+            subscription.handlers.error(error);
+        }
+    }
+
     static inline
     typename from_receiver<tag_type, Session>::result_type
     convert(task<decoded_message>::future_move_type future, std::shared_ptr<basic_receiver_t<session_type>>) {
-        const auto message = future.get();
-        const auto id = message.type();
+        return unpack(future.get());
+    }
+
+    static
+    std::vector<typename from_receiver<tag_type, Session>::result_type>
+    convert_many(task<std::vector<decoded_message>>::future_move_type future, std::shared_ptr<basic_receiver_t<session_type>>) {
+        const auto messages = future.get();
+
+        std::vector<typename from_receiver<tag_type, Session>::result_type> result;
+        result.reserve(messages.size());
+
+        for (const auto& message : messages) {
+            result.push_back(unpack(message));
+        }
+
+        return result;
+    }
 
-        auto it = unpackers.find(id);
+    static
+    typename from_receiver<tag_type, Session>::result_type
+    unpack(const decoded_message& message) {
+        const auto id = message.type();
 
-        if (it == std::end(unpackers)) {
+        if (id >= unpackers.size()) {
             throw std::runtime_error("invalid protocol");
         }
 
-        auto payload = it->second(message.args());
+        auto payload = unpackers[id](message.args());
         return from_receiver<tag_type, Session>::transform(payload);
     }
 };
@@ -233,25 +447,15 @@ public:
 };
 
 // Static unpackers variables initialization.
+//
+// Both arrays are built by constexpr functions, so they are initialized statically.
 template<class T, class Session>
-const std::unordered_map<
-    std::uint64_t,
-    typename receiver<T, Session>::unpacker_type
-> receiver<T, Session>::unpackers =
-    detail::to_map<
-        typename receiver<T, Session>::result_type::types,
-        detail::unpacker_factory<Session, typename receiver<T, Session>::unpacker_type>
-    >::make();
+const typename receiver<T, Session>::unpackers_factory::result_type
+receiver<T, Session>::unpackers = receiver<T, Session>::unpackers_factory::make();
 
 template<class T, class Session>
-const std::unordered_map<
-    std::uint64_t,
-    typename receiver<io::streaming_tag<T>, Session>::unpacker_type
-> receiver<io::streaming_tag<T>, Session>::unpackers =
-    detail::to_map<
-        typename receiver<io::streaming_tag<T>, Session>::result_type::types,
-        detail::unpacker_factory<Session, typename receiver<io::streaming_tag<T>, Session>::unpacker_type>
-    >::make();
+const typename receiver<io::streaming_tag<T>, Session>::unpackers_factory::result_type
+receiver<io::streaming_tag<T>, Session>::unpackers = receiver<io::streaming_tag<T>, Session>::unpackers_factory::make();
 
 } // namespace framework
 
@@ -19,7 +19,6 @@
 #include <array>
 #include <cstdint>
 #include <tuple>
-#include <unordered_map>
 
 #include <boost/mpl/at.hpp>
 #include <boost/mpl/front.hpp>
@@ -42,16 +41,19 @@ namespace cocaine { namespace framework {
 
 namespace detail {
 
-/// Transforms a typelist sequence into an unordered map using the given metafunction.
+/// Transforms a typelist sequence into an array using the given metafunction.
+///
+/// The N-th element of the array is produced from the N-th type of the sequence, which allows to
+/// index the array directly with protocol message type ids.
 ///
 /// \internal
 template<class Sequence, class F>
-struct to_map {
+struct to_array {
     typedef Sequence sequence_type;
     typedef typename F::result_type value_type;
     static constexpr std::size_t size = boost::mpl::size<sequence_type>::value;
 
-    typedef std::unordered_map<std::uint64_t, value_type> result_type;
+    typedef std::array<value_type, size> result_type;
 
 private:
     template<class IndexSequence>
@@ -59,13 +61,12 @@ private:
 
     template<size_t... Index>
     struct helper<index_sequence<Index...>> {
-        static inline
+        static constexpr
         result_type
         apply() {
             return result_type {{
-                Index,
-                F::template apply<typename boost::mpl::at<sequence_type, boost::mpl::int_<Index>>::type>()
-            }...};
+                F::template apply<typename boost::mpl::at<sequence_type, boost::mpl::int_<Index>>::type>()...
+            }};
         }
     };
 
@@ -277,16 +278,30 @@ struct unpacked_result<std::tuple<Args...>> {
 
 /// The metafunction to be used to fill static array with unpackers.
 ///
+/// Produces plain function pointers of the given type, so calling an unpacker neither hashes the
+/// type id nor goes through a type-erased wrapper.
+///
 /// \internal
-template<class Session, class Result>
-struct unpacker_factory {
-    typedef Result result_type;
+template<class Session, class F>
+struct unpacker_factory;
+
+template<class Session, class R, class... Args>
+struct unpacker_factory<Session, R(*)(Args...)> {
+    typedef R(*result_type)(Args...);
 
     template<class T>
-    static inline
+    static constexpr
     result_type
     apply() {
-        return unpacker<T, Session>();
+        return &unpack<T>;
+    }
+
+private:
+    template<class T>
+    static
+    R
+    unpack(Args... args) {
+        return unpacker<T, Session>()(std::forward<Args>(args)...);
     }
 };
 
@@ -25,7 +25,7 @@ namespace cocaine { namespace framework {
 
 class scheduler_t {
 public:
-    typedef std::function<void()> closure_type;
+    typedef unique_function<void()> closure_type;
 
 private:
     event_loop_t& ev;
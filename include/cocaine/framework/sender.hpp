@@ -18,6 +18,8 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <tuple>
 
 #include "cocaine/framework/encoder.hpp"
 #include "cocaine/framework/forwards.hpp"
@@ -58,11 +60,30 @@ public:
     template<class Event, class... Args>
     auto
     send(Args&&... args) -> task<void>::future_type {
-        return send(io::encoded<Event>(id, std::forward<Args>(args)...));
+        // The arguments are encoded synchronously, so it is safe to reference them.
+        const std::tuple<Args&...> refs(args...);
+        return send(encode_ref_t::make<Event>(refs));
+    }
+
+    /// Sends an event with the only string payload argument.
+    ///
+    /// Large payloads are moved into the outgoing message and written directly from there instead
+    /// of being copied into the output buffer.
+    template<class Event>
+    auto
+    send(std::string&& payload) -> task<void>::future_type {
+        if (payload.size() < encode_ref_t::share_threshold) {
+            const std::tuple<const std::string&> refs(payload);
+            return send(encode_ref_t::make<Event>(refs));
+        }
+
+        const auto owner = std::make_shared<const std::string>(std::move(payload));
+        const std::tuple<const std::string&> refs(*owner);
+        return send(encode_ref_t::make<Event>(refs).share(owner));
     }
 
 private:
-    auto send(io::encoder_t::message_type&& message) -> task<void>::future_type;
+    auto send(encode_ref_t encode) -> task<void>::future_type;
 };
 
 template<class T, class Session>
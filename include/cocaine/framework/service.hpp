@@ -16,6 +16,10 @@
 
 #pragma once
 
+#include <chrono>
+
+#include "cocaine/framework/cancellation.hpp"
+#include "cocaine/framework/deadline.hpp"
 #include "cocaine/framework/forwards.hpp"
 #include "cocaine/framework/receiver.hpp"
 #include "cocaine/framework/service.inl.hpp"
@@ -32,6 +36,10 @@
 
 namespace cocaine { namespace framework {
 
+namespace detail {
+    class watcher_t;
+} // namespace detail
+
 /// The basic service class represents an untyped Cocaine service.
 ///
 /// You are restricted to create instances of this class directly, use \sa service_manager_t for
@@ -43,11 +51,12 @@ public:
 
 private:
     class impl;
-    std::unique_ptr<impl> d;
-    std::shared_ptr<session_t> session;
+    std::shared_ptr<impl> d;
     scheduler_t& scheduler;
     internal_logger_t logger;
 
+    friend class service_manager_t;
+
 public:
     /// Constructs an instance of the service.
     ///
@@ -73,16 +82,36 @@ public:
 
     auto hard_shutdown(bool policy = true) -> void;
 
+    /// Sets how long the service endpoints resolved through the Locator are reused for
+    /// reconnecting without asking it again. Zero disables caching.
+    ///
+    /// Stale endpoints are still used while they are being refreshed in the background, but are
+    /// dropped once connecting to them fails.
+    auto resolve_ttl(std::chrono::milliseconds ttl) -> void;
+
+    /// Sets the number of connections to the service, which invocations are balanced between.
+    ///
+    /// Each invocation is sent through the less loaded of two random connections by the number of
+    /// invocations in flight, so that a single connection neither limits the throughput nor
+    /// delays all responses behind large ones. Connections are spread across the endpoints
+    /// resolved and are established on demand. Shrinking the pool closes extra connections after
+    /// their invocations are done.
+    ///
+    /// \throws std::invalid_argument if the size is zero.
+    auto pool(std::size_t size) -> void;
+
     /// Tries to connect to the service through the Locator.
     ///
-    /// \returns a future which is set after the connection is established.
+    /// \returns a future which is set after any of pooled connections is established, or with the
+    /// first error if none of them can be.
     future<void>
     connect();
 
+    /// Returns the endpoint of the first pooled connection if it is established.
     boost::optional<session_t::endpoint_type>
     endpoint() const;
 
-    /// Get the native socket representation.
+    /// Get the native socket representation of the first pooled connection.
     ///
     /// This function may be used to obtain the underlying representation of the socket. This is
     /// intended to allow access to native socket functionality that is not otherwise provided.
@@ -96,12 +125,68 @@ public:
 
         trace::context_holder holder("SI");
 
-        return connect()
+        const auto session = select();
+        return connect(session)
             .then(scheduler, trace::wrap(trace_t::bind(&basic_service_t::on_connect<Event, typename std::decay<Args>::type...>, ph::_1, session, std::forward<Args>(args)...)))
             .then(scheduler, trace::wrap(trace_t::bind(&basic_service_t::on_invoke<Event>, ph::_1)));
     }
 
+    /// Invokes the event, binding the channel created to the given cancellation token.
+    ///
+    /// Cancelling the token makes the future returned throw the operation aborted error if it is
+    /// not ready yet, revoking the channel and dropping all responses buffered in it.
+    template<class Event, class... Args>
+    typename task<typename invocation_result<Event>::type>::future_type
+    invoke(cancellation_token_t token, Args&&... args) {
+        namespace ph = std::placeholders;
+
+        trace::context_holder holder("SI");
+
+        const auto session = select();
+        return connect(session)
+            .then(scheduler, trace::wrap(trace_t::bind(&basic_service_t::on_cancellable_connect<Event, typename std::decay<Args>::type...>, ph::_1, session, std::move(token), std::forward<Args>(args)...)))
+            .then(scheduler, trace::wrap(trace_t::bind(&basic_service_t::on_invoke<Event>, ph::_1)));
+    }
+
+    /// Invokes the event with the given deadline.
+    ///
+    /// Unless the invocation completes before the deadline, its channel is revoked and the future
+    /// returned throws the timed out error. Connecting is not covered by the deadline, but no event
+    /// is sent if the deadline expires meanwhile.
+    template<class Event, class... Args>
+    typename task<typename invocation_result<Event>::type>::future_type
+    invoke(deadline_t deadline, Args&&... args) {
+        namespace ph = std::placeholders;
+
+        trace::context_holder holder("SI");
+
+        const auto session = select();
+        return connect(session)
+            .then(scheduler, trace::wrap(trace_t::bind(&basic_service_t::on_deadline_connect<Event, typename std::decay<Args>::type...>, ph::_1, session, deadline, std::forward<Args>(args)...)))
+            .then(scheduler, trace::wrap(trace_t::bind(&basic_service_t::on_invoke<Event>, ph::_1)));
+    }
+
 private:
+    /// Returns the pooled session to send the next invocation through, which is the less loaded
+    /// of two random sessions by the number of invocations in flight.
+    ///
+    /// Connected sessions are preferred to disconnected ones, which are reconnected in the
+    /// background meanwhile.
+    ///
+    /// Sessions are replaced with new ones connected to other endpoints after the Locator
+    /// announces that the service has moved, while channels opened so far remain on old ones.
+    auto select() -> std::shared_ptr<session_t>;
+
+    /// Connects the given pooled session through the Locator unless it is already connected.
+    future<void>
+    connect(std::shared_ptr<session_t> session);
+
+    /// Returns the watcher, which receives the Locator updates of this service.
+    auto watcher() const -> std::shared_ptr<detail::watcher_t>;
+
+    /// Makes this service resolve through the given Locator session shared by the manager.
+    void locator(std::shared_ptr<session_t> locator);
+
     template<class Event, class... Args>
     static
     typename task<channel<Event>>::future_type
@@ -112,6 +197,22 @@ private:
         return session->invoke<Event>(std::forward<Args>(args)...);
     }
 
+    template<class Event, class... Args>
+    static
+    typename task<channel<Event>>::future_type
+    on_cancellable_connect(task<void>::future_move_type future, std::shared_ptr<session_t> session, cancellation_token_t& token, Args&... args) {
+        future.get();
+        return session->invoke<Event>(token, std::forward<Args>(args)...);
+    }
+
+    template<class Event, class... Args>
+    static
+    typename task<channel<Event>>::future_type
+    on_deadline_connect(task<void>::future_move_type future, std::shared_ptr<session_t> session, deadline_t deadline, Args&... args) {
+        future.get();
+        return session->invoke<Event>(deadline, std::forward<Args>(args)...);
+    }
+
     template<class Event>
     static
     typename task<typename invocation_result<Event>::type>::future_type
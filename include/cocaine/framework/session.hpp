@@ -17,11 +17,14 @@
 #pragma once
 
 #include <cstdint>
+#include <tuple>
 
 #include <boost/asio/ip/tcp.hpp>
 
 #include "cocaine/framework/config.hpp"
+#include "cocaine/framework/cancellation.hpp"
 #include "cocaine/framework/channel.hpp"
+#include "cocaine/framework/deadline.hpp"
 #include "cocaine/framework/encoder.hpp"
 #include "cocaine/framework/forwards.hpp"
 #include "cocaine/framework/receiver.hpp"
@@ -65,6 +68,9 @@ public:
 
     bool connected() const;
 
+    /// Returns the number of invocations in flight, i.e. channels that are not closed yet.
+    auto inflight() const -> std::size_t;
+
     auto connect(const endpoint_type& endpoint) -> task<void>::future_type;
     auto connect(const std::vector<endpoint_type>& endpoints) -> task<void>::future_type;
 
@@ -78,17 +84,45 @@ public:
     template<class Event, class... Args>
     typename task<channel<Event>>::future_type
     invoke(Args&&... args) {
-        auto encode_cb = std::bind(
-                    &encode<Event, Args...>,
-                    std::placeholders::_1,
-                    std::forward<Args>(args)...
-        );
-        return invoke(std::move(encode_cb)).then(scheduler, trace_t::bind(&session::on_invoke<Event>, std::placeholders::_1));
+        // The arguments are encoded synchronously, so it is safe to reference them.
+        const std::tuple<Args&...> refs(args...);
+        return invoke(encode_ref_t::make<Event>(refs))
+            .then(scheduler, trace_t::bind(&session::on_invoke<Event>, std::placeholders::_1));
+    }
+
+    /// Sends an invocation event, binding the channel created to the given cancellation token.
+    ///
+    /// Cancelling the token revokes the channel and drops all messages buffered in it, so that
+    /// pending receive operations fail with the operation aborted error.
+    template<class Event, class... Args>
+    typename task<channel<Event>>::future_type
+    invoke(cancellation_token_t token, Args&&... args) {
+        const std::tuple<Args&...> refs(args...);
+        return invoke(encode_ref_t::make<Event>(refs), std::move(token))
+            .then(scheduler, trace_t::bind(&session::on_invoke<Event>, std::placeholders::_1));
+    }
+
+    /// Sends an invocation event, setting the deadline of the channel created.
+    ///
+    /// Unless the channel is closed before the deadline, it is revoked and all pending receive
+    /// operations fail with the timed out error.
+    template<class Event, class... Args>
+    typename task<channel<Event>>::future_type
+    invoke(deadline_t deadline, Args&&... args) {
+        const std::tuple<Args&...> refs(args...);
+        return invoke(encode_ref_t::make<Event>(refs), deadline)
+            .then(scheduler, trace_t::bind(&session::on_invoke<Event>, std::placeholders::_1));
     }
 
 private:
     task<basic_invoke_result>::future_type
-    invoke(encode_callback_t encode_callback);
+    invoke(encode_ref_t encode);
+
+    task<basic_invoke_result>::future_type
+    invoke(encode_ref_t encode, cancellation_token_t token);
+
+    task<basic_invoke_result>::future_type
+    invoke(encode_ref_t encode, deadline_t deadline);
 
     template<class Event>
     static
@@ -0,0 +1,105 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <exception>
+#include <functional>
+
+#include "cocaine/framework/forwards.hpp"
+
+namespace cocaine {
+
+namespace framework {
+
+/// Handlers of a streaming channel subscription.
+template<class T>
+struct stream_handlers {
+    /// Called on each incoming chunk.
+    std::function<void(T)> chunk;
+
+    /// Called once on any network, protocol or service error, including channel cancellation.
+    std::function<void(std::exception_ptr)> error;
+
+    /// Called once when the channel is closed by the other side.
+    std::function<void()> close;
+};
+
+/// The subscriber class builds a callback-driven subscription to a streaming channel, which
+/// passes incoming chunks to handlers without creating a future for each of them.
+///
+/// For example:
+/// \code{.cpp}
+/// rx.on_chunk([](std::string chunk) {
+///     // Do something with the chunk.
+/// }).on_error([](std::exception_ptr error) {
+///     // Handle the error.
+/// }).on_close([] {
+///     // The stream has finished.
+/// }).subscribe(scheduler);
+/// \endcode
+///
+/// The subscription keeps the channel alive until either it is closed or an error occurs, after
+/// which no more handlers are called.
+///
+/// \helper
+template<class T>
+class subscriber {
+public:
+    typedef std::function<void(executor_t, stream_handlers<T>)> subscribe_type;
+
+private:
+    subscribe_type fn;
+    stream_handlers<T> handlers;
+
+public:
+    subscriber(subscribe_type fn, std::function<void(T)> chunk) :
+        fn(std::move(fn))
+    {
+        handlers.chunk = std::move(chunk);
+    }
+
+    subscriber&
+    on_error(std::function<void(std::exception_ptr)> error) {
+        handlers.error = std::move(error);
+        return *this;
+    }
+
+    subscriber&
+    on_close(std::function<void()> close) {
+        handlers.close = std::move(close);
+        return *this;
+    }
+
+    /// Starts the subscription, passing chunks buffered so far and all further ones to the
+    /// handlers.
+    ///
+    /// Handlers are called sequentially on the given executor, or directly from the I/O thread if
+    /// there is no one. In the latter case they must neither block nor throw.
+    ///
+    /// \note chunks already passed to the executor are handled even if the channel is cancelled
+    /// meanwhile.
+    ///
+    /// \warning the channel must not be received from using futures after this call.
+    void
+    subscribe(executor_t executor = executor_t()) {
+        fn(std::move(executor), std::move(handlers));
+    }
+};
+
+} // namespace framework
+
+} // namespace cocaine
@@ -35,6 +35,8 @@ class future {
     friend future<Args...>
            detail::future::future_from_state<Args...>(state_type&& state, executor_t executor);
 
+    friend struct detail::future::state_access<Args...>;
+
     explicit future(state_type&& state,
                     const executor_t& executor) :
         m_state(std::move(state)),
@@ -49,7 +51,7 @@ public:
         // pass
     }
 
-    future(future&& other) :
+    future(future&& other) noexcept :
         m_state(std::move(other.m_state)),
         m_executor(std::move(other.m_executor))
     {
@@ -120,6 +122,9 @@ public:
         return detail::future::unwrapper<future<Args...>>::unwrap(std::move(*this));
     }
 
+    /// \note the continuation is called using the default executor of this future, i.e. either
+    /// inline by the thread that sets the value or through the executor attached to the future,
+    /// while the executor given is not used for dispatching.
     template<class F>
     typename detail::future::unwrapped_result<F, future<Args...>&>::type
     then(executor_t executor,
@@ -174,34 +179,40 @@ future<Args...>::then(executor_t executor,
 
     typedef decltype(callback(*this)) result_type;
 
-    future<result_type> result;
-
     if (!executor && ready()) { // Here we can call callback right now. Just a little optimization.
+        future<result_type> result;
         try {
             result = detail::future::ready_from_task(std::forward<F>(callback), *this);
         } catch (...) {
             result = make_ready_future<result_type>::error(std::current_exception());
         }
         this->invalidate();
-    } else {
-        auto new_state = std::make_shared<detail::future::shared_state<result_type>>();
-
-        detail::future::continuation_caller<result_type, future<Args...>> cont(
-            std::forward<F>(callback),
-            std::move(*this)
-        );
-
-        auto task = std::bind(detail::future::task_caller<result_type, future<Args...>&>::call,
-                              new_state,
-                              cont,
-                              std::placeholders::_1);
 
-        cont.get_future().when_ready(task);
+        return result.unwrap();
+    }
 
-        result = detail::future::future_from_state<result_type>(new_state);
+    // The continuation, its executor and its result are kept together in a single shared state
+    // callback, continuations returning futures are unwrapped in place.
+    typedef detail::future::continuation_caller<
+        result_type,
+        future<Args...>,
+        typename std::decay<F>::type
+    > caller_type;
+
+    auto new_state = std::make_shared<typename caller_type::state_type>();
+    auto source = detail::future::state_access<Args...>::shared(*this);
+
+    // Dispatching through the default executor avoids an extra event loop hop for each of
+    // continuations, which are usually attached with the scheduler given.
+    executor_t dispatch = m_executor;
+    caller_type caller(new_state, std::move(dispatch), std::forward<F>(callback), std::move(*this));
+    if (source) {
+        source->set_callback(std::move(caller));
+    } else {
+        caller();
     }
 
-    return result.unwrap();
+    return detail::future::future_from_state(new_state);
 }
 
 template<class... Args>
@@ -219,11 +230,11 @@ future<Args...>::when_ready(executor_t executor,
             executor(std::bind(std::forward<F>(callback), std::ref(*this)));
         }
     } else {
-        std::function<void()> task = std::bind(std::forward<F>(callback), std::ref(*this));
+        unique_function<void()> task(std::bind(std::forward<F>(callback), std::ref(*this)));
         if (executor) {
-            task = std::bind(executor, task);
+            task = detail::future::executor_caller(std::move(executor), std::move(task));
         }
-        m_state.template get<0>()->set_callback(task);
+        m_state.template get<0>()->set_callback(std::move(task));
     }
 }
 
@@ -332,6 +332,16 @@ struct task_caller {
     call(std::shared_ptr<shared_state<Result>> state,
          std::function<Result(Args...)> f,
          Args&&... args)
+    {
+        apply(state, f, std::forward<Args>(args)...);
+    }
+
+    template<class F>
+    static
+    void
+    apply(const std::shared_ptr<shared_state<Result>>& state,
+          F& f,
+          Args&&... args)
     {
         try {
             state->set_value(f(std::forward<Args>(args)...));
@@ -348,6 +358,16 @@ struct task_caller<void, Args...> {
     call(std::shared_ptr<shared_state<void>> state,
          std::function<void(Args...)> f,
          Args&&... args)
+    {
+        apply(state, f, std::forward<Args>(args)...);
+    }
+
+    template<class F>
+    static
+    void
+    apply(const std::shared_ptr<shared_state<void>>& state,
+          F& f,
+          Args&&... args)
     {
         try {
             f(std::forward<Args>(args)...);
@@ -358,31 +378,180 @@ struct task_caller<void, Args...> {
     }
 };
 
-// Helper to call 'then' callback with future. It stores future in heap to be copyable.
-template<class Result, class Future>
-struct continuation_caller {
+// Provides access to the shared state of a future.
+template<class... Args>
+struct state_access {
+    // Returns the shared state of the given future or nullptr if the future was made ready.
+    static
+    std::shared_ptr<shared_state<Args...>>
+    shared(cocaine::framework::future<Args...>& f) {
+        if (f.m_state.template is<0>()) {
+            return f.m_state.template get<0>();
+        }
+
+        return nullptr;
+    }
+
+    // Calls the callback once the future is ready, without touching the future afterwards.
     template<class F>
-    continuation_caller(F&& callback,
+    static
+    void
+    notify(cocaine::framework::future<Args...>& f, F&& callback) {
+        if (f.m_state.template is<0>()) {
+            f.m_state.template get<0>()->set_callback(std::forward<F>(callback));
+        } else {
+            callback();
+        }
+    }
+
+    // Detaches the callback set by notify(), unless it has been called or is being called.
+    static
+    bool
+    detach(cocaine::framework::future<Args...>& f) {
+        return f.m_state.template is<0>() && f.m_state.template get<0>()->reset_callback();
+    }
+};
+
+// Forwards the result of a future into the shared state once the future is ready.
+template<class... Args>
+struct forwarder {
+    forwarder(std::shared_ptr<shared_state<Args...>> state,
+              cocaine::framework::future<Args...>&& f) :
+        m_state(std::move(state)),
+        m_future(std::move(f))
+    {
+        // pass
+    }
+
+    void
+    operator()() {
+        try {
+            helper3<Args...>::set_value(m_state, m_future);
+        } catch (...) {
+            m_state->set_exception(std::current_exception());
+        }
+    }
+
+    static
+    void
+    forward(std::shared_ptr<shared_state<Args...>> state,
+            cocaine::framework::future<Args...>&& f)
+    {
+        auto source = state_access<Args...>::shared(f);
+
+        forwarder caller(std::move(state), std::move(f));
+        if (source) {
+            source->set_callback(std::move(caller));
+        } else {
+            caller();
+        }
+    }
+
+private:
+    std::shared_ptr<shared_state<Args...>> m_state;
+    cocaine::framework::future<Args...> m_future;
+};
+
+// Helper to call 'then' callback with future. It owns the callback, the future and the executor, so
+// it can be stored inline in the shared state callback without any extra allocations.
+//
+// If an executor is given, the caller passes itself to it when called for the first time.
+template<class Result, class Future, class F>
+struct continuation_caller {
+    typedef shared_state<Result> state_type;
+
+    template<class Callback>
+    continuation_caller(std::shared_ptr<state_type> state,
+                        executor_t executor,
+                        Callback&& callback,
+                        Future&& f) :
+        m_state(std::move(state)),
+        m_executor(std::move(executor)),
+        m_callback(std::forward<Callback>(callback)),
+        m_future(std::move(f))
+    {
+        // pass
+    }
+
+    void
+    operator()() {
+        if (m_executor) {
+            executor_t executor(std::move(m_executor));
+            m_executor = nullptr;
+            executor(std::move(*this));
+            return;
+        }
+
+        task_caller<Result, Future&>::apply(m_state, m_callback, m_future);
+    }
+
+private:
+    std::shared_ptr<state_type> m_state;
+    executor_t m_executor;
+    F m_callback;
+    Future m_future;
+};
+
+// Continuation returning a future is fused with unwrapping: its result is forwarded directly into the
+// state of the returned future instead of going through an intermediate future of future.
+template<class... Result, class Future, class F>
+struct continuation_caller<cocaine::framework::future<Result...>, Future, F> {
+    typedef shared_state<Result...> state_type;
+
+    template<class Callback>
+    continuation_caller(std::shared_ptr<state_type> state,
+                        executor_t executor,
+                        Callback&& callback,
                         Future&& f) :
-        m_callback(std::forward<F>(callback)),
-        m_future(new Future(std::move(f)))
+        m_state(std::move(state)),
+        m_executor(std::move(executor)),
+        m_callback(std::forward<Callback>(callback)),
+        m_future(std::move(f))
     {
         // pass
     }
 
-    Future&
-    get_future() const {
-        return *m_future;
+    void
+    operator()() {
+        if (m_executor) {
+            executor_t executor(std::move(m_executor));
+            m_executor = nullptr;
+            executor(std::move(*this));
+            return;
+        }
+
+        try {
+            forwarder<Result...>::forward(m_state, m_callback(m_future));
+        } catch (...) {
+            m_state->set_exception(std::current_exception());
+        }
+    }
+
+private:
+    std::shared_ptr<state_type> m_state;
+    executor_t m_executor;
+    F m_callback;
+    Future m_future;
+};
+
+// Helper to pass a task to the executor when it's called.
+struct executor_caller {
+    executor_caller(executor_t executor,
+                    unique_function<void()>&& task) :
+        m_executor(std::move(executor)),
+        m_task(std::move(task))
+    {
+        // pass
     }
 
-    Result
-    operator()(Future& f) {
-        return m_callback(f);
+    void
+    operator()() {
+        m_executor(std::move(m_task));
     }
 
 private:
-    std::function<Result(Future&)> m_callback;
-    std::shared_ptr<Future> m_future;
+    executor_t m_executor;
+    unique_function<void()> m_task;
 };
 
 template<class F, class Future>
@@ -39,6 +39,10 @@ namespace cocaine { namespace framework { namespace detail { namespace future {
 
 // shared state of promise-future
 // it's a "core" of futures, while "future" and "promise" are just wrappers to access shared state
+//
+// The state is driven by an atomic state machine: empty -> callback armed -> ready. Setting a result
+// and attaching a callback never lock, the mutex and the condition variable are used only when
+// some thread actually blocks waiting for the result.
 template<class... Args>
 class shared_state {
     COCAINE_DECLARE_NONCOPYABLE(shared_state)
@@ -52,8 +56,20 @@ class shared_state {
         exception_tag
     };
 
+    enum state_flags {
+        // some producer has started to set the result
+        claimed_flag = 1,
+        // the result is set and published
+        ready_flag = 2,
+        // the callback is set and must be called by the producer
+        callback_flag = 4,
+        // some thread is (or is going to be) blocked in wait
+        waiter_flag = 8
+    };
+
 public:
     shared_state() :
+        m_state(0),
         m_promise_counter(0),
         m_future_retrieved(false)
     {
@@ -68,10 +84,12 @@ public:
     void
     release_promise() {
         auto counter = --m_promise_counter;
-        if (counter == 0) {
-            try_set_exception(
+        // Claim first, so that fulfilled promises don't pay for building an unused exception.
+        if (counter == 0 && claim()) {
+            m_result.template set<exception_tag>(
                 cocaine::framework::make_exception_ptr(future_error(future_errc::broken_promise))
             );
+            make_ready();
         }
     }
 
@@ -82,43 +100,39 @@ public:
 
     void
     set_exception(std::exception_ptr e) {
-        std::unique_lock<std::mutex> lock(m_access_mutex);
-        if (!ready(lock)) {
-            m_result.template set<exception_tag>(e);
-            make_ready(lock);
-        } else {
+        if (!claim()) {
             throw future_error(future_errc::promise_already_satisfied);
         }
+
+        m_result.template set<exception_tag>(e);
+        make_ready();
     }
 
     void
     try_set_exception(std::exception_ptr e) {
-        std::unique_lock<std::mutex> lock(m_access_mutex);
-        if (!ready(lock)) {
+        if (claim()) {
             m_result.template set<exception_tag>(e);
-            make_ready(lock);
+            make_ready();
         }
     }
 
     template<class... Args2>
     void
     set_value(Args2&&... args) {
-        std::unique_lock<std::mutex> lock(this->m_access_mutex);
-        if (!this->ready(lock)) {
-            this->m_result.template set<value_tag>(std::forward<Args2>(args)...);
-            this->make_ready(lock);
-        } else {
+        if (!this->claim()) {
             throw future_error(future_errc::promise_already_satisfied);
         }
+
+        this->m_result.template set<value_tag>(std::forward<Args2>(args)...);
+        this->make_ready();
     }
 
     template<class... Args2>
     void
     try_set_value(Args2&&... args) {
-        std::unique_lock<std::mutex> lock(this->m_access_mutex);
-        if (!this->ready(lock)) {
+        if (this->claim()) {
             this->m_result.template set<value_tag>(std::forward<Args2>(args)...);
-            this->make_ready(lock);
+            this->make_ready();
         }
     }
 
@@ -135,8 +149,13 @@ public:
 
     void
     wait() {
+        if (ready()) {
+            return;
+        }
+
         std::unique_lock<std::mutex> lock(m_access_mutex);
-        while (!ready(lock)) {
+        m_state.fetch_or(waiter_flag);
+        while (!ready()) {
             m_ready.wait(lock);
         }
     }
@@ -144,55 +163,107 @@ public:
     template<class Rep, class Period>
     void
     wait_for(const std::chrono::duration<Rep, Period>& rel_time) {
+        if (ready()) {
+            return;
+        }
+
         std::unique_lock<std::mutex> lock(m_access_mutex);
-        m_ready.wait_for(lock, rel_time, [this, &lock]() { return ready(lock); });
+        m_state.fetch_or(waiter_flag);
+        m_ready.wait_for(lock, rel_time, [this]() { return ready(); });
     }
 
     template<class Clock, class Duration>
     void
     wait_until(const std::chrono::time_point<Clock, Duration>& timeout_time) {
-        std::unique_lock<std::mutex> lock(m_access_mutex);
-        m_ready.wait_until(lock, timeout_time, [this, &lock]() { return ready(lock); });
-    }
+        if (ready()) {
+            return;
+        }
 
-    bool
-    ready() const {
         std::unique_lock<std::mutex> lock(m_access_mutex);
-        return !m_result.empty();
+        m_state.fetch_or(waiter_flag);
+        m_ready.wait_until(lock, timeout_time, [this]() { return ready(); });
     }
 
     bool
-    ready(std::unique_lock<std::mutex>&) const {
-        return !m_result.empty();
+    ready() const {
+        return m_state.load(std::memory_order_acquire) & ready_flag;
     }
 
     template<class F>
     void
     set_callback(F&& callback) {
-        std::unique_lock<std::mutex> lock(m_access_mutex);
-        if (this->ready(lock)) {
-            lock.unlock();
+        auto state = m_state.load(std::memory_order_acquire);
+        if (state & ready_flag) {
             callback();
-        } else {
-            m_callback = std::forward<F>(callback);
+            return;
+        }
+
+        // The callback is published by the flag, so the producer never touches it before.
+        m_callback = std::forward<F>(callback);
+
+        while (!m_state.compare_exchange_weak(state, state | callback_flag, std::memory_order_acq_rel)) {
+            if (state & ready_flag) {
+                // The result has been published meanwhile, so the producer won't call the
+                // callback.
+                call_callback();
+                return;
+            }
+        }
+    }
+
+    /// Detaches the callback, that has been set but not called yet.
+    ///
+    /// \returns false if there is no callback set or the result has already been published, in
+    /// which case the callback is called by the producer anyway.
+    bool
+    reset_callback() {
+        auto state = m_state.load(std::memory_order_acquire);
+        while ((state & callback_flag) && !(state & ready_flag)) {
+            if (m_state.compare_exchange_weak(state, state & ~callback_flag, std::memory_order_acq_rel)) {
+                // The producer won't see the flag, so the callback is owned here now.
+                m_callback = unique_function<void()>();
+                return true;
+            }
         }
+
+        return false;
     }
 
 private:
+    /// Grants the exclusive right to set the result to the first caller.
+    bool
+    claim() {
+        return !(m_state.fetch_or(claimed_flag, std::memory_order_acquire) & claimed_flag);
+    }
+
     void
-    make_ready(std::unique_lock<std::mutex>& lock) {
-        m_ready.notify_all();
-        lock.unlock();
-        if (m_callback) {
-            m_callback();
-            m_callback = std::function<void()>();
+    make_ready() {
+        const auto state = m_state.fetch_or(ready_flag, std::memory_order_acq_rel);
+
+        if (state & waiter_flag) {
+            // Taking the lock guarantees that the waiter either has not checked the state yet or
+            // is already blocked on the condition variable.
+            std::lock_guard<std::mutex> lock(m_access_mutex);
+            m_ready.notify_all();
+        }
+
+        if (state & callback_flag) {
+            call_callback();
         }
     }
 
+    void
+    call_callback() {
+        auto callback = std::move(m_callback);
+        callback();
+    }
+
 private:
     result_type m_result;
 
-    std::function<void()> m_callback;
+    unique_function<void()> m_callback;
+
+    std::atomic<int> m_state;
 
     mutable std::mutex m_access_mutex;
     std::condition_variable m_ready;
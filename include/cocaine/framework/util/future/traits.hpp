@@ -24,9 +24,11 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include <tuple>
 #include <functional>
 
+#include <cocaine/framework/util/future/unique_function.hpp>
+
 namespace cocaine { namespace framework {
 
-typedef std::function<void(std::function<void()>)> executor_t;
+typedef std::function<void(unique_function<void()>)> executor_t;
 
 namespace detail { namespace future {
 
@@ -0,0 +1,257 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COCAINE_FRAMEWORK_FUTURE_UNIQUE_FUNCTION_HPP
+#define COCAINE_FRAMEWORK_FUTURE_UNIQUE_FUNCTION_HPP
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cocaine { namespace framework {
+
+template<class Signature>
+class unique_function;
+
+/// Move-only polymorphic function wrapper.
+///
+/// Unlike std::function it accepts move-only callables and keeps callables up to the given
+/// capacity inline, so wrapping a typical continuation doesn't allocate. Larger callables and
+/// callables that may throw on move are stored on the heap.
+template<class R, class... Args>
+class unique_function<R(Args...)> {
+public:
+    /// The maximum size of a callable to be stored inline.
+    static const std::size_t capacity = 24 * sizeof(void*);
+
+private:
+    typedef typename std::aligned_storage<capacity, std::alignment_of<void*>::value>::type storage_type;
+
+    struct vtable_type {
+        R(*call)(storage_type& storage, Args&&... args);
+        void(*move)(storage_type& from, storage_type& to);
+        void(*destroy)(storage_type& storage);
+    };
+
+    template<class Result, class = void>
+    struct invoker {
+        template<class F>
+        static
+        Result
+        apply(F& fn, Args&&... args) {
+            return fn(std::forward<Args>(args)...);
+        }
+    };
+
+    template<class Dummy>
+    struct invoker<void, Dummy> {
+        template<class F>
+        static
+        void
+        apply(F& fn, Args&&... args) {
+            fn(std::forward<Args>(args)...);
+        }
+    };
+
+    template<class F>
+    struct local {
+        static
+        F&
+        get(storage_type& storage) {
+            return *reinterpret_cast<F*>(&storage);
+        }
+
+        static
+        R
+        call(storage_type& storage, Args&&... args) {
+            return invoker<R>::apply(get(storage), std::forward<Args>(args)...);
+        }
+
+        static
+        void
+        move(storage_type& from, storage_type& to) {
+            new(&to) F(std::move(get(from)));
+            get(from).~F();
+        }
+
+        static
+        void
+        destroy(storage_type& storage) {
+            get(storage).~F();
+        }
+    };
+
+    template<class F>
+    struct remote {
+        static
+        F*&
+        get(storage_type& storage) {
+            return *reinterpret_cast<F**>(&storage);
+        }
+
+        static
+        R
+        call(storage_type& storage, Args&&... args) {
+            return invoker<R>::apply(*get(storage), std::forward<Args>(args)...);
+        }
+
+        static
+        void
+        move(storage_type& from, storage_type& to) {
+            new(&to) F*(get(from));
+        }
+
+        static
+        void
+        destroy(storage_type& storage) {
+            delete get(storage);
+        }
+    };
+
+    template<class F>
+    struct is_local :
+        public std::integral_constant<bool,
+            sizeof(F) <= sizeof(storage_type) &&
+            std::alignment_of<F>::value <= std::alignment_of<storage_type>::value &&
+            std::is_nothrow_move_constructible<F>::value
+        >
+    {};
+
+    template<class Storage>
+    struct vtable {
+        static const vtable_type value;
+    };
+
+    const vtable_type* vt;
+    storage_type storage;
+
+public:
+    unique_function() noexcept :
+        vt(nullptr)
+    {}
+
+    unique_function(std::nullptr_t) noexcept :
+        vt(nullptr)
+    {}
+
+    template<
+        class F,
+        class = typename std::enable_if<
+            !std::is_same<typename std::decay<F>::type, unique_function>::value
+        >::type
+    >
+    unique_function(F&& fn) :
+        vt(nullptr)
+    {
+        typedef typename std::decay<F>::type function_type;
+        assign<function_type>(std::forward<F>(fn), is_local<function_type>());
+    }
+
+    unique_function(unique_function&& other) noexcept :
+        vt(other.vt)
+    {
+        if (vt) {
+            vt->move(other.storage, storage);
+            other.vt = nullptr;
+        }
+    }
+
+    unique_function(const unique_function& other) = delete;
+
+    ~unique_function() {
+        reset();
+    }
+
+    unique_function&
+    operator=(unique_function&& other) noexcept {
+        if (this != &other) {
+            reset();
+
+            if (other.vt) {
+                other.vt->move(other.storage, storage);
+                vt = other.vt;
+                other.vt = nullptr;
+            }
+        }
+
+        return *this;
+    }
+
+    unique_function&
+    operator=(const unique_function& other) = delete;
+
+    unique_function&
+    operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    explicit
+    operator bool() const noexcept {
+        return vt != nullptr;
+    }
+
+    /// \throw std::bad_function_call if the wrapper is empty.
+    R
+    operator()(Args... args) {
+        if (!vt) {
+            throw std::bad_function_call();
+        }
+
+        return vt->call(storage, std::forward<Args>(args)...);
+    }
+
+private:
+    void
+    reset() noexcept {
+        if (vt) {
+            vt->destroy(storage);
+            vt = nullptr;
+        }
+    }
+
+    template<class T, class F>
+    void
+    assign(F&& fn, std::true_type) {
+        new(&storage) T(std::forward<F>(fn));
+        vt = &vtable<local<T>>::value;
+    }
+
+    template<class T, class F>
+    void
+    assign(F&& fn, std::false_type) {
+        new(&storage) T*(new T(std::forward<F>(fn)));
+        vt = &vtable<remote<T>>::value;
+    }
+};
+
+template<class R, class... Args>
+const std::size_t unique_function<R(Args...)>::capacity;
+
+template<class R, class... Args>
+template<class Storage>
+const typename unique_function<R(Args...)>::vtable_type unique_function<R(Args...)>::vtable<Storage>::value = {
+    &Storage::call,
+    &Storage::move,
+    &Storage::destroy
+};
+
+}} // namespace cocaine::framework
+
+#endif // COCAINE_FRAMEWORK_FUTURE_UNIQUE_FUNCTION_HPP
@@ -21,8 +21,11 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #ifndef COCAINE_FRAMEWORK_FUTURE_UTILITY_HPP
 #define COCAINE_FRAMEWORK_FUTURE_UTILITY_HPP
 
+#include <cocaine/framework/cancellation.hpp>
 #include <cocaine/framework/util/future/future.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <boost/range.hpp>
 
@@ -125,57 +128,6 @@ private:
     std::recursive_mutex m_futures_mutex;
 };
 
-template<class T>
-class when_any_vector_state :
-    public std::enable_shared_from_this<when_any_vector_state<T>>
-{
-public:
-    when_any_vector_state(std::vector<T>&& futures) :
-        m_futures(std::move(futures)),
-        m_cake(false)
-    {
-        // pass
-    }
-
-    cocaine::framework::future<std::vector<T>>
-    subscribe() {
-        if (m_futures.size() == 0) {
-            m_promise.set_value(std::move(m_futures));
-        } else {
-            for (size_t i = 0; i < m_futures.size(); ++i) {
-                std::unique_lock<std::recursive_mutex> lock(m_futures_mutex);
-
-                if (!m_cake) {
-                    m_futures[i].when_ready(executor_t(),
-                                            std::bind(&when_any_vector_state<T>::make_ready,
-                                                      this->shared_from_this(),
-                                                      std::placeholders::_1));
-                } else {
-                    break;
-                }
-            }
-        }
-
-        return m_promise.get_future();
-    }
-
-    void
-    make_ready(T&) {
-        std::unique_lock<std::recursive_mutex> lock(m_futures_mutex);
-        if (!m_cake) {
-            m_cake = true;
-            lock.unlock();
-            m_promise.set_value(std::move(m_futures));
-        }
-    }
-
-private:
-    promise<std::vector<T>> m_promise;
-    std::vector<T> m_futures;
-    bool m_cake;
-    std::recursive_mutex m_futures_mutex;
-};
-
 // when_all implementation
 
 template<class... Futures>
@@ -258,47 +210,91 @@ private:
     std::atomic<unsigned int> m_cake;
 };
 
+// Vectored when_n implementation, which when_any and when_all are built upon.
+//
+// The state is allocated once per call and owns the futures. Readiness is tracked by a single
+// countdown, which starts at the quorum plus one for the subscription itself, so the result is
+// never set while the futures are still being subscribed. Each future gets a pointer-sized
+// callback registered right on its shared state, which keeps the state alive by an intrusive
+// counter instead of a shared pointer copy.
+//
+// Once the quorum is reached, callbacks of the futures left pending are detached before the
+// futures are handed out, releasing their references. So the state never outlives the result
+// waiting for futures nobody cares about, and the futures are free to get their own callbacks.
 template<class T>
-class when_all_vector_state :
-    public std::enable_shared_from_this<when_all_vector_state<T>>
-{
+class when_n_vector_state {
+    COCAINE_DECLARE_NONCOPYABLE(when_n_vector_state)
+
+    struct notifier_t {
+        when_n_vector_state* state;
+
+        void
+        operator()() {
+            state->notify();
+        }
+    };
+
 public:
-    when_all_vector_state(std::vector<T>&& futures) :
+    when_n_vector_state(std::vector<T>&& futures, size_t quorum) :
         m_futures(std::move(futures)),
-        m_cake(m_futures.size())
+        m_pending(std::min(quorum, m_futures.size()) + 1),
+        m_refs(m_futures.size() + 1)
     {
         // pass
     }
 
     cocaine::framework::future<std::vector<T>>
     subscribe() {
-        if (m_futures.size() == 0) {
-            m_promise.set_value(std::move(m_futures));
-        } else {
-            for (size_t i = 0; i < m_futures.size(); ++i) {
-                m_futures[i].when_ready(executor_t(),
-                                        std::bind(&when_all_vector_state<T>::make_ready<T>,
-                                                  this->shared_from_this(),
-                                                  std::placeholders::_1));
-            }
+        auto future = m_promise.get_future();
+
+        for (size_t i = 0; i < m_futures.size(); ++i) {
+            subscribe(m_futures[i]);
         }
 
-        return m_promise.get_future();
+        notify();
+
+        return future;
     }
 
-    template<class Future>
+private:
+    template<class... Args>
     void
-    make_ready(Future&) {
-        unsigned int counter = --(this->m_cake);
-        if (counter == 0) {
+    subscribe(cocaine::framework::future<Args...>& future) {
+        state_access<Args...>::notify(future, notifier_t{this});
+    }
+
+    template<class... Args>
+    static
+    bool
+    detach(cocaine::framework::future<Args...>& future) {
+        return state_access<Args...>::detach(future);
+    }
+
+    void
+    notify() {
+        size_t released = 1;
+
+        // Surplus notifications drive the countdown below zero, so only one of them sees zero.
+        if (--m_pending == 0) {
+            for (size_t i = 0; i < m_futures.size(); ++i) {
+                if (detach(m_futures[i])) {
+                    ++released;
+                }
+            }
+
             m_promise.set_value(std::move(m_futures));
         }
+
+        if (m_refs.fetch_sub(released) == released) {
+            delete this;
+        }
     }
 
 private:
     promise<std::vector<T>> m_promise;
     std::vector<T> m_futures;
-    std::atomic<unsigned int> m_cake;
+    std::atomic<long> m_pending;
+    std::atomic<size_t> m_refs;
 };
 
 }} // namespace detail::future
@@ -331,38 +327,73 @@ when_all(Futures&&... futures) {
     return state->subscribe();
 }
 
+/// Returns a future, which becomes ready with all the futures once the given number of them are
+/// ready. The quorum is clamped to the number of futures.
+///
+/// \note the result keeps all the futures in their original order instead of only the ready
+/// ones, so they can be matched with the operations they came from. At least the quorum of them
+/// are ready, the rest may still become ready later.
+///
+/// \threadsafe
 template<class Range>
 future<std::vector<typename boost::range_value<Range>::type>>
-when_any(Range& range) {
-    std::vector<typename boost::range_value<Range>::type> result;
+when_n(Range& range, size_t quorum) {
+    typedef typename boost::range_value<Range>::type future_type;
+
+    std::vector<future_type> result;
+    result.reserve(boost::distance(range));
 
     for (auto it = boost::begin(range); it != boost::end(range); ++it) {
         result.emplace_back(std::move(*it));
     }
 
-    typedef detail::future::when_any_vector_state<typename boost::range_value<Range>::type>
-            state_type;
-
-    auto state = std::make_shared<state_type>(std::move(result));
+    auto state = new detail::future::when_n_vector_state<future_type>(std::move(result), quorum);
 
     return state->subscribe();
 }
 
+template<class Range>
+future<std::vector<typename boost::range_value<Range>::type>>
+when_any(Range& range) {
+    return when_n(range, 1);
+}
+
 template<class Range>
 future<std::vector<typename boost::range_value<Range>::type>>
 when_all(Range& range) {
-    std::vector<typename boost::range_value<Range>::type> result;
+    return when_n(range, boost::distance(range));
+}
 
-    for (auto it = boost::begin(range); it != boost::end(range); ++it) {
-        result.emplace_back(std::move(*it));
-    }
+/// Same as above, but cancels the tokens of operations, which are still pending once the quorum
+/// is reached, abandoning them.
+///
+/// Tokens are matched with futures by their position, so each operation must be started with its
+/// own token. Tokens of ready operations are left intact, keeping streaming channels obtained from
+/// them opened.
+///
+/// \note an operation, which completes right after the quorum is reached, may still be cancelled.
+template<class Range>
+future<std::vector<typename boost::range_value<Range>::type>>
+when_n(Range& range, size_t quorum, std::vector<cancellation_token_t> tokens) {
+    typedef std::vector<typename boost::range_value<Range>::type> result_type;
 
-    typedef detail::future::when_all_vector_state<typename boost::range_value<Range>::type>
-            state_type;
+    return when_n(range, quorum).then([tokens](future<result_type>& future) mutable -> result_type {
+        auto result = future.get();
 
-    auto state = std::make_shared<state_type>(std::move(result));
+        for (size_t id = 0; id < std::min(result.size(), tokens.size()); ++id) {
+            if (!result[id].ready()) {
+                tokens[id].cancel();
+            }
+        }
 
-    return state->subscribe();
+        return result;
+    });
+}
+
+template<class Range>
+future<std::vector<typename boost::range_value<Range>::type>>
+when_any(Range& range, std::vector<cancellation_token_t> tokens) {
+    return when_n(range, 1, std::move(tokens));
 }
 
 }} // namespace cocaine::framework
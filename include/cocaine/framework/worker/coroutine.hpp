@@ -0,0 +1,73 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "cocaine/framework/coroutine.hpp"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <exception>
+#include <functional>
+
+#include "cocaine/framework/worker.hpp"
+#include "cocaine/framework/worker/sender.hpp"
+#include "cocaine/framework/worker/receiver.hpp"
+
+namespace cocaine { namespace framework { namespace worker {
+
+/// Event tag for coroutine handlers.
+///
+/// \code{.cpp}
+/// worker.on<worker::coroutine>("ping", &handle);
+/// \endcode
+struct coroutine;
+
+/// The transform traits specialization for coroutine handlers.
+///
+/// The future returned by the coroutine is kept until the coroutine completes. An exception
+/// escaping the coroutine is treated like one escaping a regular handler: if it is thrown before
+/// the first suspension, it propagates from the handler into the executor thread, otherwise the
+/// worker is terminated.
+template<class Dispatch>
+struct transform_traits<Dispatch, coroutine> {
+    typedef std::function<future<void>(sender, receiver)> input_type;
+
+    static
+    typename Dispatch::handler_type
+    apply(input_type handler) {
+        return [handler](sender tx, receiver rx) {
+            auto fr = handler(std::move(tx), std::move(rx));
+
+            if (fr.ready()) {
+                fr.get();
+                return;
+            }
+
+            fr.then([](future<void>& fr) {
+                try {
+                    fr.get();
+                } catch (...) {
+                    std::terminate();
+                }
+            });
+        };
+    }
+};
+
+}}} // namespace cocaine::framework::worker
+
+#endif
@@ -237,6 +237,26 @@ public:
 
         return rx.recv();
     }
+
+    /*!
+     * Tries to receive all chunks of data buffered so far, but no more than the given number.
+     *
+     * \return a future, which will be set after receiving at least one message from the stream.
+     * Only its last element may be none, indicating that the other side has closed the stream for
+     * writing.
+     */
+    task<std::vector<boost::optional<std::string>>>::future_type
+    recv_many(std::size_t max) {
+        if (cached) {
+            cached = false;
+
+            std::vector<boost::optional<std::string>> chunks;
+            chunks.emplace_back(body);
+            return make_ready_future<std::vector<boost::optional<std::string>>>::value(std::move(chunks));
+        }
+
+        return rx.recv_many(max);
+    }
 };
 
 /*!
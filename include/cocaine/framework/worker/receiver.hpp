@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <boost/optional/optional.hpp>
 
@@ -25,6 +27,7 @@
 #include <cocaine/hpack/header.hpp>
 
 #include "cocaine/framework/forwards.hpp"
+#include "cocaine/framework/subscriber.hpp"
 
 namespace cocaine {
 namespace framework {
@@ -49,6 +52,22 @@ public:
 
     template<typename R = std::string>
     auto recv() -> future<boost::optional<R>>;
+
+    /// Receives all chunks buffered so far, but no more than the given number, or the next one if
+    /// there are no buffered chunks.
+    ///
+    /// \returns a future with the non-empty vector of chunks, only the last of which can be none,
+    /// indicating that the other side has closed the stream. If any of chunks received is an
+    /// error, the future throws it, dropping the rest.
+    auto recv_many(std::size_t max) -> future<std::vector<boost::optional<std::string>>>;
+
+    /// Starts building a callback-driven subscription with the given chunk handler.
+    ///
+    /// Unlike recv() it does not create a future for each chunk, passing them to handlers right
+    /// after they are read, so prefer it for long streams.
+    ///
+    /// \warning recv() must not be called after the subscription has been started.
+    auto on_chunk(std::function<void(std::string)> fn) -> subscriber<std::string>;
 };
 
 template<>
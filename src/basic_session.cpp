@@ -18,12 +18,13 @@
 
 #include <memory>
 
-#include <asio/connect.hpp>
+#include <asio/write.hpp>
 
 #include "cocaine/framework/sender.hpp"
 #include "cocaine/framework/scheduler.hpp"
 #include "cocaine/framework/trace.hpp"
 
+#include "cocaine/framework/detail/connector.hpp"
 #include "cocaine/framework/detail/log.hpp"
 #include "cocaine/framework/detail/loop.hpp"
 #include "cocaine/framework/detail/net.hpp"
@@ -37,50 +38,6 @@ using namespace cocaine;
 using namespace cocaine::framework;
 using namespace cocaine::framework::detail;
 
-/// \note single shot.
-class basic_session_t::push_t:
-    public std::enable_shared_from_this<push_t>
-{
-    const io::encoder_t::message_type message;
-
-    // Keeps the session alive until all the operations are complete.
-    const std::shared_ptr<basic_session_t> session;
-
-    promise<void> pr;
-
-public:
-    push_t(io::encoder_t::message_type&& message,
-           std::shared_ptr<basic_session_t> session,
-           promise<void>&& pr) :
-        message(std::move(message)),
-        session(std::move(session)),
-        pr(std::move(pr))
-    {}
-
-    void
-    operator()(std::shared_ptr<transport_type> transport) {
-        CF_DBG("writing message ...");
-
-        transport->writer->write(
-            message,
-            trace::wrap(std::bind(&push_t::on_write, shared_from_this(), ph::_1))
-        );
-    }
-
-private:
-    void
-    on_write(const std::error_code& ec) {
-        CF_DBG("<< write: %s", CF_EC(ec));
-
-        if (ec) {
-            session->on_error(ec);
-            pr.set_exception(std::system_error(ec));
-        } else {
-            pr.set_value();
-        }
-    }
-};
-
 basic_session_t::basic_session_t(scheduler_t& scheduler) noexcept :
     scheduler(scheduler),
     closed(false),
@@ -96,6 +53,10 @@ bool basic_session_t::connected() const noexcept {
     return state == static_cast<int>(state_t::connected);
 }
 
+auto basic_session_t::inflight() const noexcept -> std::size_t {
+    return channels.size();
+}
+
 auto basic_session_t::connect(const endpoint_type& endpoint) -> task<std::error_code>::future_type {
     return connect(std::vector<endpoint_type> {{ endpoint }});
 }
@@ -113,10 +74,12 @@ basic_session_t::connect(const std::vector<endpoint_type>& endpoints) {
 
     if (exchanged) {
         // The transport is disconnected, perform connecting.
-        std::unique_ptr<socket_type> socket;
+        std::shared_ptr<connector_t> connector;
 
         try {
-            socket.reset(new socket_type(scheduler.loop().loop));
+            connector = std::make_shared<connector_t>(
+                scheduler.loop().loop, endpoints_cast<asio::ip::tcp::endpoint>(endpoints)
+            );
         } catch (const std::exception& err) {
             CF_DBG("<< failed: %s", err.what());
 
@@ -125,17 +88,9 @@ basic_session_t::connect(const std::vector<endpoint_type>& endpoints) {
             return fr;
         }
 
-        const auto converted = endpoints_cast<asio::ip::tcp::endpoint>(endpoints);
-
-        socket_type& socket_ref = *socket;
-        asio::async_connect(
-            socket_ref,
-            converted.begin(), converted.end(),
-            trace::wrap(trace_t::bind(
-				&basic_session_t::on_connect,
-                shared_from_this(), ph::_1, std::move(pr), std::move(socket)
-			))
-        );
+        connector->connect(trace::wrap(trace_t::bind(
+            &basic_session_t::on_connect, shared_from_this(), ph::_1, std::move(pr), ph::_2
+        )));
     } else {
         // The transport was in other state.
 
@@ -162,8 +117,18 @@ auto basic_session_t::hard_shutdown(bool policy) -> void {
 
 boost::optional<basic_session_t::endpoint_type>
 basic_session_t::endpoint() const {
-    // TODO: Implement `basic_session_t::endpoint()`.
-    return boost::none;
+    const auto transport = *this->transport.synchronize();
+    if (!connected() || !transport) {
+        return boost::none;
+    }
+
+    std::error_code ec;
+    const auto endpoint = transport->socket->remote_endpoint(ec);
+    if (ec) {
+        return boost::none;
+    }
+
+    return endpoint_cast(endpoint);
 }
 
 basic_session_t::native_handle_type
@@ -176,7 +141,7 @@ basic_session_t::cancel() {
     CF_DBG(">> disconnecting ...");
 
     closed = true;
-    if (channels->empty() || hard_shutdown_) {
+    if (channels.empty() || hard_shutdown_) {
         CF_DBG("<< stop listening");
         transport.synchronize()->reset();
     }
@@ -186,20 +151,86 @@ basic_session_t::cancel() {
 
 framework::future<basic_session_t::invoke_result>
 basic_session_t::invoke(encode_callback_t encode_callback) {
-    // Synchronization here is required to prevent channel id mixing in multi-threaded environment.
-    std::lock_guard<std::mutex> lock(mutex);
+    return invoke_with([&](push_t& push, std::uint64_t span) {
+        push.message.reset(new io::encoder_t::message_type(encode_callback(span)));
+    }, [](receiver_type&) {});
+}
+
+framework::future<basic_session_t::invoke_result>
+basic_session_t::invoke(encode_ref_t encode) {
+    return invoke_with([&](push_t& push, std::uint64_t span) {
+        push.buffer = buffers.acquire();
+        encode(push.buffer, span);
+    }, [](receiver_type&) {});
+}
+
+framework::future<basic_session_t::invoke_result>
+basic_session_t::invoke(encode_ref_t encode, cancellation_token_t token) {
+    if (token.cancelled()) {
+        return make_ready_future<invoke_result>::error(std::system_error(asio::error::operation_aborted));
+    }
+
+    return invoke_with([&](push_t& push, std::uint64_t span) {
+        push.buffer = buffers.acquire();
+        encode(push.buffer, span);
+    }, [&](receiver_type& rx) {
+        rx.bind(token);
+    });
+}
+
+framework::future<basic_session_t::invoke_result>
+basic_session_t::invoke(encode_ref_t encode, deadline_t deadline) {
+    if (deadline.expired()) {
+        return make_ready_future<invoke_result>::error(std::system_error(asio::error::timed_out));
+    }
+
+    return invoke_with([&](push_t& push, std::uint64_t span) {
+        push.buffer = buffers.acquire();
+        encode(push.buffer, span);
+    }, [&](receiver_type& rx) {
+        rx.expire(deadline);
+    });
+}
 
+template<class Encode, class Bind>
+framework::future<basic_session_t::invoke_result>
+basic_session_t::invoke_with(Encode encode, Bind bind) {
+    push_t push;
+    auto fr = push.pr.get_future();
+
+    // Spans are allocated without locking, the outbox restores their order before writing.
     const auto span = counter++;
 
     CF_CTX("bI" + std::to_string(span));
     CF_DBG("invoking span %llu event ...", CF_US(span));
 
-    auto tx    = std::make_shared<basic_sender_t<basic_session_t>>(span, shared_from_this());
-    auto state = std::make_shared<shared_state_t>();
-    auto rx    = std::make_shared<basic_receiver_t<basic_session_t>>(span, shared_from_this(), state);
+    std::shared_ptr<basic_sender_t<basic_session_t>> tx;
+    std::shared_ptr<basic_receiver_t<basic_session_t>> rx;
+
+    try {
+        tx = std::make_shared<basic_sender_t<basic_session_t>>(span, shared_from_this());
+
+        auto state = std::make_shared<shared_state_t>();
+        rx = std::make_shared<basic_receiver_t<basic_session_t>>(span, shared_from_this(), state);
+
+        channels.insert(span, std::move(state));
+
+        // Bound after the channel is registered, so that an already cancelled token or an
+        // expired deadline revokes it.
+        bind(*rx);
+
+        encode(push, span);
+    } catch (...) {
+        // Release the span anyway, otherwise all subsequent invocations stall.
+        channels.erase(span);
+        enqueue(span, nullptr);
+        buffers.release(std::move(push.buffer));
+        throw;
+    }
+
+    enqueue(span, &push);
 
-    channels->insert(std::make_pair(span, std::move(state)));
-    return push(encode_callback(span))
+    return fr
         .then(scheduler, trace::wrap([tx, rx](future<void>& fr) -> invoke_result {
             fr.get();
             return std::make_tuple(tx, rx);
@@ -209,29 +240,122 @@ basic_session_t::invoke(encode_callback_t encode_callback) {
 framework::future<void>
 basic_session_t::push(io::encoder_t::message_type&& message) {
     CF_CTX("bP");
-    CF_DBG(">> writing message ...");
+    CF_DBG(">> enqueueing message ...");
 
     promise<void> pr;
     auto fr = pr.get_future();
 
-    auto transport = *this->transport.synchronize();
-    if (transport) {
-        auto pusher = std::make_shared<push_t>(std::move(message), shared_from_this(), std::move(pr));
-        (*pusher)(transport);
-    } else {
-        pr.set_exception(std::system_error(asio::error::not_connected));
+    send(push_t{
+        detail::buffer_t(),
+        std::unique_ptr<io::encoder_t::message_type>(new io::encoder_t::message_type(std::move(message))),
+        std::move(pr)
+    });
+
+    return fr;
+}
+
+framework::future<void>
+basic_session_t::push(std::uint64_t span, encode_ref_t encode) {
+    CF_CTX("bP");
+    CF_DBG(">> enqueueing span %llu message ...", CF_US(span));
+
+    auto buffer = buffers.acquire();
+
+    try {
+        encode(buffer, span);
+    } catch (...) {
+        buffers.release(std::move(buffer));
+        throw;
     }
 
+    promise<void> pr;
+    auto fr = pr.get_future();
+
+    send(push_t{std::move(buffer), nullptr, std::move(pr)});
+
     return fr;
 }
 
+void
+basic_session_t::send(push_t&& push) {
+    if (!*this->transport.synchronize()) {
+        push.pr.set_exception(std::system_error(asio::error::not_connected));
+        return;
+    }
+
+    const bool scheduled = outbox.apply([&](outbox_t& outbox) -> bool {
+        outbox.queue.push_back(std::move(push));
+        return schedule(outbox);
+    });
+
+    if (scheduled) {
+        scheduler.loop().loop.post(trace::wrap(std::bind(&basic_session_t::flush, shared_from_this())));
+    }
+}
+
+void
+basic_session_t::enqueue(std::uint64_t span, push_t* push) {
+    if (push && !*this->transport.synchronize()) {
+        push->pr.set_exception(std::system_error(asio::error::not_connected));
+        push = nullptr;
+    }
+
+    const bool scheduled = outbox.apply([&](outbox_t& outbox) -> bool {
+        if (span != outbox.next) {
+            CF_DBG("deferring span %llu until span %llu is queued", CF_US(span), CF_US(outbox.next));
+
+            std::unique_ptr<push_t> deferred;
+            if (push) {
+                deferred.reset(new push_t(std::move(*push)));
+            }
+
+            outbox.pending.insert(std::make_pair(span, std::move(deferred)));
+            return false;
+        }
+
+        if (push) {
+            outbox.queue.push_back(std::move(*push));
+        }
+
+        ++outbox.next;
+
+        // Admit invocations that have been waiting for this one.
+        auto it = outbox.pending.begin();
+        while (it != outbox.pending.end() && it->first == outbox.next) {
+            if (it->second) {
+                outbox.queue.push_back(std::move(*it->second));
+            }
+
+            ++outbox.next;
+            it = outbox.pending.erase(it);
+        }
+
+        return schedule(outbox);
+    });
+
+    if (scheduled) {
+        scheduler.loop().loop.post(trace::wrap(std::bind(&basic_session_t::flush, shared_from_this())));
+    }
+}
+
+bool
+basic_session_t::schedule(outbox_t& outbox) {
+    if (outbox.flushing || outbox.queue.empty()) {
+        // The messages will be written either by the already scheduled flush or after the current
+        // write operation completes.
+        return false;
+    }
+
+    outbox.flushing = true;
+    return true;
+}
+
 void
 basic_session_t::revoke(std::uint64_t span) {
     CF_DBG(">> revoking span %llu channel", CF_US(span));
 
-    auto channels = this->channels.synchronize();
-    channels->erase(span);
-    if (closed && channels->empty()) {
+    channels.erase(span);
+    if (closed && channels.empty()) {
         // At this moment there are no references left to this session and also nobody is intrested
         // for data reading.
         CF_DBG("<< stop listening");
@@ -241,8 +365,13 @@ basic_session_t::revoke(std::uint64_t span) {
     CF_DBG("<< revoke span %llu channel", CF_US(span));
 }
 
+auto
+basic_session_t::timers() -> detail::timer_wheel_t& {
+    return scheduler.loop().timers;
+}
+
 void
-basic_session_t::on_connect(const std::error_code& ec, promise<std::error_code> pr, std::unique_ptr<socket_type>& socket) {
+basic_session_t::on_connect(const std::error_code& ec, promise<std::error_code> pr, std::unique_ptr<socket_type> socket) {
     CF_DBG("<< connect: %s", CF_EC(ec));
 
     if (ec) {
@@ -272,18 +401,10 @@ basic_session_t::on_read(const std::error_code& ec) {
     }
 
     CF_DBG("received message [%llu, %llu, %s]", CF_US(message.span()), CF_US(message.type()), CF_MSG(message.args()).c_str());
-    auto state = channels.apply([&](channel_map_type& channels) -> std::shared_ptr<shared_state_t> {
-         auto it = channels.find(message.span());
-         if (it == channels.end()) {
-             CF_DBG("dropping an orphan span %llu message", CF_US(message.span()));
-             return nullptr;
-         } else {
-             return it->second;
-         }
-    });
-
-    if (state) {
+    if (auto state = channels.find(message.span())) {
         state->put(std::move(message));
+    } else {
+        CF_DBG("dropping an orphan span %llu message", CF_US(message.span()));
     }
 
     auto transport = this->transport.synchronize();
@@ -298,14 +419,8 @@ basic_session_t::on_error(const std::error_code& ec) {
 
     state = static_cast<std::uint8_t>(state_t::disconnected);
 
-    auto channels = this->channels.apply([&](channel_map_type& channels) -> channel_map_type {
-        auto copy = channels;
-        channels.clear();
-        return copy;
-    });
-
-    for (auto channel : channels) {
-        channel.second->put(ec);
+    for (auto& channel : channels.drain()) {
+        channel->put(ec);
     }
 }
 
@@ -319,6 +434,74 @@ basic_session_t::pull(std::shared_ptr<transport_type> transport) {
     );
 }
 
+void
+basic_session_t::flush() {
+    auto batch = std::make_shared<queue_type>();
+
+    outbox.apply([&](outbox_t& outbox) {
+        batch->swap(outbox.queue);
+
+        if (batch->empty()) {
+            outbox.flushing = false;
+        }
+    });
+
+    if (batch->empty()) {
+        return;
+    }
+
+    auto transport = *this->transport.synchronize();
+    if (!transport) {
+        for (auto& push : *batch) {
+            push.pr.set_exception(std::system_error(asio::error::not_connected));
+            buffers.release(std::move(push.buffer));
+        }
+
+        flush();
+        return;
+    }
+
+    std::vector<asio::const_buffer> sequence;
+    sequence.reserve(batch->size());
+    for (const auto& push : *batch) {
+        push.gather(sequence);
+    }
+
+    CF_DBG(">> writing %llu message(s) ...", CF_US(batch->size()));
+
+    // The transport is bound to keep the socket alive until the operation completes, even if the
+    // session has been cancelled meanwhile.
+    asio::async_write(
+        *transport->socket,
+        sequence,
+        trace::wrap(std::bind(&basic_session_t::on_write, shared_from_this(), ph::_1, batch, transport))
+    );
+}
+
+void
+basic_session_t::on_write(const std::error_code& ec, std::shared_ptr<queue_type> batch, std::shared_ptr<transport_type>) {
+    CF_DBG("<< write: %s", CF_EC(ec));
+
+    if (ec) {
+        on_error(ec);
+
+        for (auto& push : *batch) {
+            push.pr.set_exception(std::system_error(ec));
+        }
+    } else {
+        for (auto& push : *batch) {
+            push.pr.set_value();
+        }
+    }
+
+    for (auto& push : *batch) {
+        buffers.release(std::move(push.buffer));
+    }
+
+    // Write messages that have been queued while this operation was in progress.
+    flush();
+}
+
 #include "sender.cpp"
 template class cocaine::framework::basic_sender_t<basic_session_t>;
 
@@ -0,0 +1,58 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/framework/detail/buffer.hpp"
+
+using namespace cocaine::framework::detail;
+
+const std::size_t buffer_t::share_threshold;
+
+const std::size_t buffer_pool_t::capacity;
+const std::size_t buffer_pool_t::max_buffer_capacity;
+
+auto
+buffer_pool_t::acquire() -> buffer_t {
+    return buffers.apply([](std::vector<buffer_t>& buffers) -> buffer_t {
+        if (buffers.empty()) {
+            return buffer_t();
+        }
+
+        auto buffer = std::move(buffers.back());
+        buffers.pop_back();
+        return buffer;
+    });
+}
+
+void
+buffer_pool_t::release(buffer_t&& buffer) noexcept {
+    if (buffer.capacity() == 0 || buffer.capacity() > max_buffer_capacity) {
+        return;
+    }
+
+    buffer.clear();
+
+    buffers.apply([&](std::vector<buffer_t>& buffers) {
+        if (buffers.size() >= capacity) {
+            return;
+        }
+
+        try {
+            buffers.push_back(std::move(buffer));
+        } catch (const std::bad_alloc&) {
+            // The buffer is freed by its owner.
+        }
+    });
+}
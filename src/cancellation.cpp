@@ -0,0 +1,106 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/framework/cancellation.hpp"
+
+#include <atomic>
+#include <unordered_map>
+
+#include <cocaine/locked_ptr.hpp>
+
+using namespace cocaine::framework;
+
+class cancellation_token_t::state_t {
+public:
+    typedef std::unordered_map<subscription_type, callback_type> callbacks_type;
+
+    struct inner_t {
+        bool cancelled;
+        subscription_type counter;
+        callbacks_type callbacks;
+
+        inner_t() : cancelled(false), counter(0) {}
+    };
+
+    /// Duplicates the cancelled flag to be able to check it without locking.
+    std::atomic<bool> cancelled;
+    synchronized<inner_t> inner;
+
+    state_t() :
+        cancelled(false)
+    {}
+};
+
+cancellation_token_t::cancellation_token_t() :
+    d(std::make_shared<state_t>())
+{}
+
+void
+cancellation_token_t::cancel() {
+    state_t::callbacks_type callbacks;
+
+    const bool cancelled = d->inner.apply([&](state_t::inner_t& inner) -> bool {
+        if (inner.cancelled) {
+            return false;
+        }
+
+        inner.cancelled = true;
+        callbacks.swap(inner.callbacks);
+        return true;
+    });
+
+    if (!cancelled) {
+        return;
+    }
+
+    d->cancelled = true;
+
+    // Callbacks are called without the lock held, so they are free to use the token.
+    for (auto& callback : callbacks) {
+        callback.second();
+    }
+}
+
+bool
+cancellation_token_t::cancelled() const noexcept {
+    return d->cancelled;
+}
+
+auto
+cancellation_token_t::subscribe(callback_type callback) -> subscription_type {
+    const auto id = d->inner.apply([&](state_t::inner_t& inner) -> subscription_type {
+        if (inner.cancelled) {
+            return 0;
+        }
+
+        const auto id = ++inner.counter;
+        inner.callbacks.insert(std::make_pair(id, std::move(callback)));
+        return id;
+    });
+
+    if (id == 0) {
+        callback();
+    }
+
+    return id;
+}
+
+void
+cancellation_token_t::unsubscribe(subscription_type id) {
+    d->inner.apply([&](state_t::inner_t& inner) {
+        inner.callbacks.erase(id);
+    });
+}
@@ -0,0 +1,94 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/framework/detail/channel_map.hpp"
+
+using namespace cocaine::framework::detail;
+
+const std::size_t channel_map_t::shards;
+
+channel_map_t::channel_map_t() :
+    count(0)
+{}
+
+void
+channel_map_t::insert(std::uint64_t span, value_type state) {
+    // The counter is updated under the shard lock, so that it never goes below the number of
+    // channels actually registered, even for a moment.
+    shard(span).apply([&](shard_type& shard) {
+        if (shard.insert(std::make_pair(span, std::move(state))).second) {
+            ++count;
+        }
+    });
+}
+
+auto
+channel_map_t::find(std::uint64_t span) -> value_type {
+    return shard(span).apply([&](shard_type& shard) -> value_type {
+        auto it = shard.find(span);
+        if (it == shard.end()) {
+            return nullptr;
+        }
+
+        return it->second;
+    });
+}
+
+auto
+channel_map_t::erase(std::uint64_t span) -> bool {
+    return shard(span).apply([&](shard_type& shard) -> bool {
+        if (shard.erase(span) > 0) {
+            --count;
+            return true;
+        }
+
+        return false;
+    });
+}
+
+auto
+channel_map_t::drain() -> std::vector<value_type> {
+    std::vector<value_type> result;
+
+    for (auto& shard : data) {
+        shard_type drained;
+        shard.apply([&](shard_type& shard) {
+            drained.swap(shard);
+            count -= drained.size();
+        });
+
+        for (auto& channel : drained) {
+            result.push_back(std::move(channel.second));
+        }
+    }
+
+    return result;
+}
+
+auto
+channel_map_t::empty() const noexcept -> bool {
+    return count == 0;
+}
+
+auto
+channel_map_t::size() const noexcept -> std::size_t {
+    return count;
+}
+
+auto
+channel_map_t::shard(std::uint64_t span) -> synchronized<shard_type>& {
+    return data[span % shards];
+}
@@ -0,0 +1,189 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/framework/detail/connector.hpp"
+
+#include <algorithm>
+
+#include "cocaine/framework/detail/log.hpp"
+
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+namespace {
+
+/// Reorders the given endpoints, alternating address families and starting with the family of
+/// the first endpoint.
+auto
+interleave(std::vector<connector_t::endpoint_type> endpoints) -> std::vector<connector_t::endpoint_type> {
+    if (endpoints.empty()) {
+        return endpoints;
+    }
+
+    const bool v6 = endpoints.front().address().is_v6();
+
+    std::vector<connector_t::endpoint_type> preferred;
+    std::vector<connector_t::endpoint_type> other;
+
+    for (const auto& endpoint : endpoints) {
+        if (endpoint.address().is_v6() == v6) {
+            preferred.push_back(endpoint);
+        } else {
+            other.push_back(endpoint);
+        }
+    }
+
+    std::vector<connector_t::endpoint_type> result;
+    result.reserve(endpoints.size());
+
+    for (std::size_t id = 0; id < std::max(preferred.size(), other.size()); ++id) {
+        if (id < preferred.size()) {
+            result.push_back(preferred[id]);
+        }
+
+        if (id < other.size()) {
+            result.push_back(other[id]);
+        }
+    }
+
+    return result;
+}
+
+} // namespace
+
+const std::chrono::milliseconds connector_t::default_delay = std::chrono::milliseconds(250);
+
+connector_t::connector_t(loop_t& loop, std::vector<endpoint_type> endpoints, std::chrono::milliseconds delay) :
+    loop(loop),
+    endpoints(interleave(std::move(endpoints))),
+    delay(delay),
+    sockets(this->endpoints.size()),
+    timer(loop),
+    next(0),
+    pending(0),
+    done(false)
+{}
+
+void
+connector_t::connect(handler_type handler) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    this->handler = std::move(handler);
+
+    if (endpoints.empty()) {
+        done = true;
+
+        auto self = shared_from_this();
+        loop.post([self] {
+            auto handler = std::move(self->handler);
+            handler(asio::error::not_found, std::unique_ptr<socket_type>());
+        });
+
+        return;
+    }
+
+    start();
+}
+
+void
+connector_t::start() {
+    const auto id = next++;
+
+    CF_DBG(">> connecting to endpoint %llu of %llu ...",
+        static_cast<unsigned long long>(id + 1), static_cast<unsigned long long>(endpoints.size()));
+
+    sockets[id].reset(new socket_type(loop));
+    ++pending;
+
+    auto self = shared_from_this();
+    sockets[id]->async_connect(endpoints[id], [self, id](const std::error_code& ec) {
+        self->on_connect(ec, id);
+    });
+
+    if (next < endpoints.size()) {
+        // Rearming the timer aborts the previous wait, if any.
+        timer.expires_from_now(delay);
+        timer.async_wait([self, id](const std::error_code& ec) {
+            self->on_timer(ec, id);
+        });
+    }
+}
+
+void
+connector_t::on_connect(const std::error_code& ec, std::size_t id) {
+    std::unique_ptr<socket_type> socket;
+    handler_type handler;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        --pending;
+        if (done) {
+            return;
+        }
+
+        if (ec) {
+            CF_DBG("<< attempt %llu failed: %s", static_cast<unsigned long long>(id + 1), ec.message().c_str());
+
+            error = ec;
+            sockets[id].reset();
+
+            // Don't wait for the timer, there is no reason to delay the next attempt anymore.
+            if (next < endpoints.size()) {
+                start();
+                return;
+            }
+
+            if (pending > 0) {
+                return;
+            }
+        } else {
+            CF_DBG("<< attempt %llu succeeded", static_cast<unsigned long long>(id + 1));
+            socket = std::move(sockets[id]);
+        }
+
+        done = true;
+        cancel();
+        handler = std::move(this->handler);
+    }
+
+    handler(socket ? std::error_code() : error, std::move(socket));
+}
+
+void
+connector_t::on_timer(const std::error_code& ec, std::size_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // The attempt following the given one may have already been started after a failure.
+    if (ec || done || next != id + 1) {
+        return;
+    }
+
+    start();
+}
+
+void
+connector_t::cancel() {
+    timer.cancel();
+
+    for (auto& socket : sockets) {
+        if (socket) {
+            std::error_code ec;
+            socket->close(ec);
+            socket.reset();
+        }
+    }
+}
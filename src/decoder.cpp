@@ -16,6 +16,7 @@
 
 #include "cocaine/framework/detail/decoder.hpp"
 
+#include <cstring>
 #include <memory>
 
 #include <msgpack/object.hpp>
@@ -32,19 +33,242 @@
 
 #include "cocaine/framework/message.hpp"
 
+#include "cocaine/framework/detail/zone.hpp"
+
 using namespace cocaine::framework::detail;
 
-size_t decoder_t::decode(const char* data, size_t size, message_type& message, std::error_code& ec) {
+namespace {
+
+/// Element kinds, that differ in the way the scanner advances over them.
+enum class kind_t {
+    /// Element without payload, except the fixed size one included in the header.
+    scalar,
+    /// Element followed by the payload of length specified in the header.
+    raw,
+    /// Array or map.
+    container
+};
+
+/// Reads big-endian unsigned integer of the given width.
+std::uint64_t
+load(const unsigned char* data, size_t width) {
+    std::uint64_t result = 0;
+    for (size_t id = 0; id < width; ++id) {
+        result = (result << 8) | data[id];
+    }
+
+    return result;
+}
+
+/// Checks whether all headers are literals, that are not stored into the dynamic table.
+///
+/// Such headers neither depend on nor affect the header table state, so their decoding can be
+/// postponed until they are actually accessed. The check also covers the whole structure the
+/// postponed decoding relies on, so malformed header blocks are rejected right away.
+bool
+literal(const msgpack::object& headers) {
+    for (std::size_t id = 0; id < headers.via.array.size; ++id) {
+        const auto& header = headers.via.array.ptr[id];
+
+        if (header.type != msgpack::type::ARRAY || header.via.array.size != 3) {
+            return false;
+        }
+
+        const auto* fields = header.via.array.ptr;
+        if (fields[0].type != msgpack::type::BOOLEAN || fields[0].via.boolean) {
+            return false;
+        }
+
+        if (fields[1].type != msgpack::type::RAW || fields[2].type != msgpack::type::RAW) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+scanner_t::scanner_t(size_t limit) :
+    limit(limit),
+    offset(0),
+    done(false),
+    missing(0)
+{}
+
+size_t scanner_t::scan(const char* data, size_t size, std::error_code& ec) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+
+    while (!done) {
+        if (offset >= size) {
+            missing = offset - size + 1;
+            ec = error::insufficient_bytes;
+            return 0;
+        }
+
+        const unsigned char type = bytes[offset];
+
+        // Header size including the type byte, width of the length field and the multiplier
+        // applied to it: the count for containers and the payload size for raw elements.
+        kind_t kind = kind_t::scalar;
+        size_t header = 1;
+        size_t width = 0;
+        std::uint64_t length = 0;
+        std::uint64_t factor = 1;
+
+        if (type <= 0x7f || type >= 0xe0 || type == 0xc0 || type == 0xc2 || type == 0xc3) {
+            // Fixint, nil or boolean.
+        } else if (type <= 0x8f) {
+            kind = kind_t::container;
+            length = type & 0x0f;
+            factor = 2;
+        } else if (type <= 0x9f) {
+            kind = kind_t::container;
+            length = type & 0x0f;
+        } else if (type <= 0xbf) {
+            kind = kind_t::raw;
+            length = type & 0x1f;
+        } else {
+            switch (type) {
+            case 0xc4: case 0xc5: case 0xc6:
+                // Bin 8/16/32.
+                kind = kind_t::raw;
+                width = 1 << (type - 0xc4);
+                break;
+            case 0xc7: case 0xc8: case 0xc9:
+                // Ext 8/16/32, the type byte follows the length.
+                kind = kind_t::raw;
+                width = 1 << (type - 0xc7);
+                header += 1;
+                break;
+            case 0xca: header += 4; break;
+            case 0xcb: header += 8; break;
+            case 0xcc: case 0xcd: case 0xce: case 0xcf:
+                header += 1 << (type - 0xcc);
+                break;
+            case 0xd0: case 0xd1: case 0xd2: case 0xd3:
+                header += 1 << (type - 0xd0);
+                break;
+            case 0xd4: case 0xd5: case 0xd6: case 0xd7: case 0xd8:
+                // Fixext 1/2/4/8/16 with the type byte.
+                header += 1 + (1 << (type - 0xd4));
+                break;
+            case 0xd9: case 0xda: case 0xdb:
+                // Str 8/16/32.
+                kind = kind_t::raw;
+                width = 1 << (type - 0xd9);
+                break;
+            case 0xdc: case 0xdd:
+                kind = kind_t::container;
+                width = 2 << (type - 0xdc);
+                break;
+            case 0xde: case 0xdf:
+                kind = kind_t::container;
+                width = 2 << (type - 0xde);
+                factor = 2;
+                break;
+            default:
+                ec = error::parse_error;
+                return 0;
+            }
+        }
+
+        header += width;
+        if (offset + header > size) {
+            missing = offset + header - size;
+            ec = error::insufficient_bytes;
+            return 0;
+        }
+
+        if (width > 0) {
+            length = load(bytes + offset + 1, width);
+        }
+
+        offset += header;
+
+        // Each container element takes at least one byte, so the frame size can be bounded before
+        // any of them is received.
+        if (offset + length * factor > limit) {
+            ec = error::frame_format_error;
+            return 0;
+        }
+
+        if (kind == kind_t::container && length > 0) {
+            stack.push_back(length * factor);
+            continue;
+        }
+
+        if (kind == kind_t::raw) {
+            // The payload is skipped without looking at it, even if it is not received yet.
+            offset += length;
+        }
+
+        complete();
+    }
+
+    if (offset > size) {
+        missing = offset - size;
+        ec = error::insufficient_bytes;
+        return 0;
+    }
+
+    const size_t result = offset;
+    offset = 0;
+    done = false;
+    missing = 0;
+    return result;
+}
+
+size_t scanner_t::remaining() const noexcept {
+    return missing;
+}
+
+void scanner_t::complete() {
+    while (!stack.empty()) {
+        if (--stack.back() > 0) {
+            return;
+        }
+
+        stack.pop_back();
+    }
+
+    done = true;
+}
+
+const size_t decoder_t::copy_threshold;
+const size_t decoder_t::max_frame_size;
+
+decoder_t::decoder_t() :
+    scanner(max_frame_size)
+{}
+
+size_t decoder_t::decode(const slab_ptr& slab, const char* data, size_t size, message_type& message, std::error_code& ec) {
+    const size_t frame = scanner.scan(data, size, ec);
+    if (ec) {
+        return 0;
+    }
+
     size_t offset = 0;
 
     msgpack::object object;
-    std::vector<char> buffer(size);
-    memcpy(buffer.data(), data, size);
-    std::unique_ptr<msgpack::zone> zone(new msgpack::zone{});
-    msgpack::unpack_return rv = msgpack::unpack(buffer.data(), size, &offset, &*zone, &object);
+    auto zone = acquire_zone();
+
+    // Small frames are copied into the zone, which the message owns anyway, instead of pinning
+    // the whole slab for as long as the message lives.
+    slab_ptr owner;
+    if (frame <= copy_threshold) {
+        char* copy = static_cast<char*>(zone->malloc_no_align(frame));
+        std::memcpy(copy, data, frame);
+        data = copy;
+    } else {
+        owner = slab;
+    }
+
+    msgpack::unpack_return rv = msgpack::unpack(data, frame, &offset, &*zone, &object);
 
     if(rv == msgpack::UNPACK_SUCCESS || rv == msgpack::UNPACK_EXTRA_BYTES) {
         std::vector<hpack::header_t> headers;
+        bool lazy = true;
         bool error = false;
         error = error || object.type != msgpack::type::ARRAY;
         error = error || object.via.array.size < 3;
@@ -53,17 +277,27 @@ size_t decoder_t::decode(const char* data, size_t size, message_type& message, s
         error = error || object.via.array.ptr[2].type != msgpack::type::ARRAY;
         if(object.via.array.size > 3) {
             error = error || object.via.array.ptr[3].type != msgpack::type::ARRAY;
-            error = error || !hpack::msgpack_traits::unpack_vector(object.via.array.ptr[3], header_table, headers);
+            // Headers affecting the table must be decoded right now to keep it consistent.
+            lazy = !error && literal(object.via.array.ptr[3]);
+            if(!lazy) {
+                error = error || !hpack::msgpack_traits::unpack_vector(object.via.array.ptr[3], header_table, headers);
+            }
         }
         if(error) {
             ec = error::frame_format_error;
+        } else if(lazy) {
+            message = message_type(std::move(object), std::move(zone), std::move(owner));
+        } else {
+            message = message_type(std::move(object), std::move(zone), std::move(owner), std::move(headers));
         }
-        message = message_type(std::move(object), std::move(zone), std::move(buffer), std::move(headers));
-    } else if(rv == msgpack::UNPACK_CONTINUE) {
-        ec = error::insufficient_bytes;
-    } else if(rv == msgpack::UNPACK_PARSE_ERROR) {
+    } else {
+        // The scanner has already made sure that the frame is complete.
         ec = error::parse_error;
     }
 
     return offset;
 }
+
+size_t decoder_t::remaining() const noexcept {
+    return scanner.remaining();
+}
@@ -0,0 +1,193 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/framework/detail/discovery.hpp"
+
+#include <algorithm>
+#include <map>
+
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+#include <cocaine/idl/locator.hpp>
+#include <cocaine/traits/endpoint.hpp>
+#include <cocaine/traits/graph.hpp>
+#include <cocaine/traits/map.hpp>
+#include <cocaine/traits/tuple.hpp>
+#include <cocaine/traits/vector.hpp>
+
+#include "cocaine/framework/scheduler.hpp"
+#include "cocaine/framework/session.hpp"
+#include "cocaine/framework/trace.hpp"
+
+#include "cocaine/framework/detail/basic_session.hpp"
+#include "cocaine/framework/detail/log.hpp"
+#include "cocaine/framework/detail/loop.hpp"
+#include "cocaine/framework/detail/net.hpp"
+
+namespace ph = std::placeholders;
+
+using namespace cocaine;
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+namespace {
+
+typedef std::tuple<std::vector<asio::ip::tcp::endpoint>, uint, io::graph_root_t> resolve_result;
+
+/// A single chunk of the locator's routing stream, i.e. the locator's uuid and services announced
+/// by it.
+typedef std::tuple<std::string, std::map<std::string, resolve_result>> connect_result;
+
+std::string
+generate_uuid() {
+    return boost::uuids::to_string(boost::uuids::random_generator()());
+}
+
+task<channel<io::locator::connect>>::future_type
+on_connect(task<void>::future_move_type future, std::shared_ptr<framework::session_t> locator, std::string uuid) {
+    future.get();
+
+    CF_DBG("<< connect to the locator: ok");
+    CF_DBG(">> subscribing ...");
+    return locator->invoke<io::locator::connect>(std::move(uuid));
+}
+
+} // namespace
+
+const std::chrono::milliseconds discovery_t::retry_interval = std::chrono::seconds(1);
+
+discovery_t::discovery_t(scheduler_t& scheduler, std::vector<endpoint_type> endpoints) :
+    scheduler(scheduler),
+    endpoints(std::move(endpoints)),
+    running(false)
+{}
+
+discovery_t::~discovery_t() {}
+
+void discovery_t::attach(std::weak_ptr<watcher_t> watcher) {
+    watchers.apply([&](std::vector<std::weak_ptr<watcher_t>>& watchers) {
+        // Watchers are attached for each service created, while updates, which drop expired ones
+        // too, may never come unless subscribed. Weak pointers also keep the memory of objects
+        // created with make_shared.
+        watchers.erase(std::remove_if(watchers.begin(), watchers.end(), [](const std::weak_ptr<watcher_t>& watcher) {
+            return watcher.expired();
+        }), watchers.end());
+
+        watchers.push_back(std::move(watcher));
+    });
+}
+
+void discovery_t::start() {
+    if (!running.exchange(true)) {
+        // Both are required only after subscribing.
+        uuid = generate_uuid();
+        locator = std::make_shared<framework::session_t>(scheduler);
+        locator->hard_shutdown(true);
+
+        subscribe();
+    }
+}
+
+void discovery_t::update(const std::string& name, const result_type& result) {
+    std::vector<std::shared_ptr<watcher_t>> matched;
+
+    watchers.apply([&](std::vector<std::weak_ptr<watcher_t>>& watchers) {
+        for (auto it = watchers.begin(); it != watchers.end();) {
+            if (auto watcher = it->lock()) {
+                if (watcher->name() == name) {
+                    matched.push_back(std::move(watcher));
+                }
+                ++it;
+            } else {
+                it = watchers.erase(it);
+            }
+        }
+    });
+
+    // Watchers are notified without holding the lock, allowing them to attach other ones.
+    for (const auto& watcher : matched) {
+        watcher->update(result);
+    }
+}
+
+void discovery_t::subscribe() {
+    CF_CTX("D");
+
+    auto connected = make_ready_future<void>::value();
+    if (!locator->connected()) {
+        CF_DBG(">> connecting to the locator ...");
+        connected = locator->connect(endpoints);
+    }
+
+    std::weak_ptr<discovery_t> weak(shared_from_this());
+
+    connected
+        .then(scheduler, trace::wrap(trace_t::bind(&on_connect, ph::_1, locator, uuid)))
+        .then(scheduler, [weak](task<channel<io::locator::connect>>::future_move_type future) {
+            auto self = weak.lock();
+            if (!self) {
+                return;
+            }
+
+            try {
+                auto channel = future.get();
+
+                // The locator sends the whole routing table first, then only the services that
+                // have changed.
+                channel.rx.on_chunk([weak](connect_result chunk) {
+                    auto self = weak.lock();
+                    if (!self) {
+                        return;
+                    }
+
+                    for (const auto& service : std::get<1>(chunk)) {
+                        const result_type result = {
+                            endpoints_cast<boost::asio::ip::tcp::endpoint>(std::get<0>(service.second)),
+                            std::get<1>(service.second)
+                        };
+
+                        self->update(service.first, result);
+                    }
+                }).on_error([weak](std::exception_ptr) {
+                    if (auto self = weak.lock()) {
+                        self->resubscribe();
+                    }
+                }).on_close([weak] {
+                    if (auto self = weak.lock()) {
+                        self->resubscribe();
+                    }
+                }).subscribe();
+            } catch (const std::exception& err) {
+                CF_DBG("<< subscribing - error: %s", err.what());
+                self->resubscribe();
+            }
+        });
+}
+
+void discovery_t::resubscribe() {
+    CF_DBG("subscription to the locator has broken, resubscribing in %lld ms",
+        static_cast<long long>(retry_interval.count()));
+
+    std::weak_ptr<discovery_t> weak(shared_from_this());
+
+    scheduler.loop().timers.schedule(timer_wheel_t::clock_type::now() + retry_interval, [weak] {
+        if (auto self = weak.lock()) {
+            self->subscribe();
+        }
+    });
+}
@@ -0,0 +1,41 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/framework/encoder.hpp"
+
+#include "cocaine/framework/detail/buffer.hpp"
+
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+static_assert(encode_ref_t::share_threshold == buffer_t::share_threshold,
+    "payloads worth sharing must not be copied by the buffer");
+
+const std::size_t encode_ref_t::share_threshold;
+
+void
+buffer_stream_t::write(const char* data, std::size_t size) {
+    buffer.write(data, size);
+}
+
+void
+encode_ref_t::operator()(buffer_t& buffer, std::uint64_t span) const {
+    if (payload) {
+        buffer.share(*payload);
+    }
+
+    function(buffer, span, args);
+}
@@ -25,6 +25,7 @@
 #include "cocaine/framework/scheduler.hpp"
 #include "cocaine/framework/service.hpp"
 
+#include "cocaine/framework/detail/discovery.hpp"
 #include "cocaine/framework/detail/loop.hpp"
 #include "cocaine/framework/detail/runnable.hpp"
 
@@ -78,6 +79,12 @@ public:
 
     std::vector<boost::thread> threads;
 
+    /// Subscription to the Locator, which is started on demand.
+    std::shared_ptr<discovery_t> discovery;
+
+    /// The Locator session, which all services created resolve through.
+    std::shared_ptr<session_t> locator;
+
     std::shared_ptr<service<io::log_tag>> logger;
 
     service_manager_data(std::vector<session_t::endpoint_type> locations_) :
@@ -86,8 +93,12 @@ public:
         scheduler(event_loop),
         shutdown_policy(service_manager_t::shutdown_policy_t::graceful),
         locations(std::move(locations_)),
+        discovery(std::make_shared<discovery_t>(scheduler, locations)),
+        locator(std::make_shared<session_t>(scheduler)),
         logger(std::make_shared<service<io::log_tag>>(internal_logger_t(), "logging", locations, scheduler))
-    {}
+    {
+        locator->hard_shutdown(true);
+    }
 };
 
 namespace {
@@ -151,6 +162,8 @@ service_manager_t::~service_manager_t() {
     // Reset an own copy of a logger shared pointer to be able to join threads gracefully.
     // Otherwise they will wait forever until all asynchronous operations completes.
     d->logger.reset();
+    d->discovery.reset();
+    d->locator.reset();
 
     d->work.reset();
 
@@ -174,6 +187,8 @@ service_manager_t::start(unsigned int threads) {
         throw std::invalid_argument("thread count must be a positive number");
     }
 
+    attach(*d->logger);
+
     for (unsigned int i = 0; i < threads; ++i) {
         d->threads.emplace_back(named_runnable<loop_t>("[CF::M]", d->io));
     }
@@ -184,6 +199,17 @@ service_manager_t::next() {
     return d->scheduler;
 }
 
+void
+service_manager_t::attach(basic_service_t& service) {
+    service.locator(d->locator);
+    d->discovery->attach(service.watcher());
+}
+
+void
+service_manager_t::watch() {
+    d->discovery->start();
+}
+
 std::shared_ptr<service<io::log_tag>>
 service_manager_t::logger() const {
     return d->logger;
@@ -17,6 +17,8 @@
 #include "cocaine/framework/message.hpp"
 
 #include <algorithm>
+#include <limits>
+#include <system_error>
 #include <type_traits>
 #include <vector>
 
@@ -25,57 +27,141 @@
 #include <msgpack/unpack.hpp>
 #include <msgpack/zone.hpp>
 
+#include <cocaine/errors.hpp>
+
 #include <cocaine/hpack/header.hpp>
+#include <cocaine/hpack/msgpack_traits.hpp>
+#include <cocaine/hpack/static_table.hpp>
+
+#include "cocaine/framework/detail/zone.hpp"
 
+using namespace cocaine;
 using namespace cocaine::framework;
 
-class decoded_message::inner_t {
-public:
-    inner_t() {}
+namespace {
 
-    inner_t(msgpack::object _obj, std::unique_ptr<msgpack::zone> zone, std::vector<char>&& _storage, hpack::header_storage_t _headers) :
-        obj(std::move(_obj)),
-        zone(std::move(zone)),
-        storage(std::move(_storage)),
-        headers(std::move(_headers))
-    {}
+const std::size_t npos = std::numeric_limits<std::size_t>::max();
 
-    msgpack::object obj;
-    std::unique_ptr<msgpack::zone> zone;
-    std::vector<char> storage;
-    hpack::header_storage_t headers;
-};
+} // namespace
 
 decoded_message::decoded_message(boost::none_t) :
-    d(new inner_t)
+    span_(0),
+    type_(0),
+    args_(nullptr),
+    packed(nullptr),
+    indexed(false)
 {}
 
 decoded_message::decoded_message(msgpack::object obj, std::vector<char>&& storage, std::vector<hpack::header_t> headers) :
-    d(new inner_t(std::move(obj), std::unique_ptr<msgpack::zone>(new msgpack::zone{}), std::move(storage), std::move(headers)))
+    decoded_message(std::move(obj), detail::acquire_zone(), std::move(storage), std::move(headers))
 {}
 
 decoded_message::decoded_message(msgpack::object obj, std::unique_ptr<msgpack::zone> zone, std::vector<char> storage, std::vector<hpack::header_t> headers) :
-    d(new inner_t(std::move(obj), std::move(zone), std::move(storage), std::move(headers)))
+    span_(obj.via.array.ptr[0].as<std::uint64_t>()),
+    type_(obj.via.array.ptr[1].as<std::uint64_t>()),
+    args_(&obj.via.array.ptr[2]),
+    zone(std::move(zone)),
+    storage(std::move(storage)),
+    packed(nullptr),
+    headers(std::move(headers)),
+    indexed(false)
 {}
 
-decoded_message::~decoded_message() = default;
-
-decoded_message::decoded_message(decoded_message&& other) = default;
+decoded_message::decoded_message(msgpack::object obj, std::unique_ptr<msgpack::zone> zone, detail::slab_ptr slab, std::vector<hpack::header_t> headers) :
+    span_(obj.via.array.ptr[0].as<std::uint64_t>()),
+    type_(obj.via.array.ptr[1].as<std::uint64_t>()),
+    args_(&obj.via.array.ptr[2]),
+    zone(std::move(zone)),
+    slab(std::move(slab)),
+    packed(nullptr),
+    headers(std::move(headers)),
+    indexed(false)
+{}
 
-auto decoded_message::operator=(decoded_message&& other) -> decoded_message& = default;
+decoded_message::decoded_message(msgpack::object obj, std::unique_ptr<msgpack::zone> zone, detail::slab_ptr slab) :
+    span_(obj.via.array.ptr[0].as<std::uint64_t>()),
+    type_(obj.via.array.ptr[1].as<std::uint64_t>()),
+    args_(&obj.via.array.ptr[2]),
+    zone(std::move(zone)),
+    slab(std::move(slab)),
+    packed(obj.via.array.size > 3 ? &obj.via.array.ptr[3] : nullptr),
+    indexed(false)
+{}
 
-auto decoded_message::span() const -> uint64_t {
-    return d->obj.via.array.ptr[0].as<uint64_t>();
+decoded_message::~decoded_message() {
+    detail::release_zone(std::move(zone));
 }
 
-auto decoded_message::type() const -> uint64_t {
-    return d->obj.via.array.ptr[1].as<uint64_t>();
+decoded_message::decoded_message(decoded_message&& other) = default;
+
+auto decoded_message::operator=(decoded_message&& other) -> decoded_message& {
+    if (this != &other) {
+        detail::release_zone(std::move(zone));
+
+        span_ = other.span_;
+        type_ = other.type_;
+        args_ = other.args_;
+        zone = std::move(other.zone);
+        storage = std::move(other.storage);
+        slab = std::move(other.slab);
+        packed = other.packed;
+        headers = std::move(other.headers);
+        indexed = other.indexed;
+        tracing = other.tracing;
+    }
+
+    return *this;
 }
 
-auto decoded_message::args() const -> const msgpack::object& {
-    return d->obj.via.array.ptr[2];
+auto decoded_message::meta() const -> const std::vector<hpack::header_t>& {
+    if (packed) {
+        // Literal headers are neither looked up in nor stored into the table, so any table will
+        // do, and this one is never modified.
+        static hpack::header_table_t table;
+
+        const auto* raw = packed;
+        packed = nullptr;
+
+        // The decoder has already checked the structure, so this may only fail for messages
+        // constructed by hand. Never leave a partially decoded list behind.
+        if (!hpack::msgpack_traits::unpack_vector(*raw, table, headers)) {
+            headers.clear();
+            throw std::system_error(cocaine::error::frame_format_error);
+        }
+    }
+
+    return headers;
 }
 
-auto decoded_message::meta() const noexcept -> const std::vector<hpack::header_t>& {
-    return d->headers;
+auto decoded_message::lookup(std::size_t slot) const -> boost::optional<hpack::header_t> {
+    if (!indexed) {
+        tracing.fill(npos);
+
+        const auto& headers = meta();
+        for (std::size_t id = 0; id < headers.size(); ++id) {
+            const auto& name = headers[id].name();
+
+            std::size_t found = npos;
+            if (name == hpack::headers::trace_id<>::name()) {
+                found = detail::tracing_header<hpack::headers::trace_id<>>::value;
+            } else if (name == hpack::headers::span_id<>::name()) {
+                found = detail::tracing_header<hpack::headers::span_id<>>::value;
+            } else if (name == hpack::headers::parent_id<>::name()) {
+                found = detail::tracing_header<hpack::headers::parent_id<>>::value;
+            }
+
+            // Keep the first occurrence, as the linear lookup does.
+            if (found != npos && tracing[found] == npos) {
+                tracing[found] = id;
+            }
+        }
+
+        indexed = true;
+    }
+
+    if (tracing[slot] == npos) {
+        return boost::none;
+    }
+
+    return headers[tracing[slot]];
 }
@@ -16,20 +16,54 @@
 
 #include "cocaine/framework/receiver.hpp"
 
+#include <asio/error.hpp>
+
 #include "cocaine/framework/detail/shared_state.hpp"
 #include "cocaine/framework/detail/log.hpp"
+#include "cocaine/framework/detail/timer_wheel.hpp"
 
 using namespace cocaine::framework;
 
+namespace {
+
+/// Breaks the channel state with the given error and revokes its span, unless the channel has
+/// already gone.
+template<class Session>
+void
+abandon(const std::weak_ptr<Session>& session,
+        const std::weak_ptr<shared_state_t>& state,
+        std::uint64_t id,
+        const std::error_code& ec)
+{
+    if (auto locked = state.lock()) {
+        locked->cancel(ec);
+    }
+
+    if (auto locked = session.lock()) {
+        locked->revoke(id);
+    }
+}
+
+} // namespace
+
 template<class Session>
 basic_receiver_t<Session>::basic_receiver_t(std::uint64_t id, std::shared_ptr<Session> session, std::shared_ptr<shared_state_t> state) :
     id(id),
     session(std::move(session)),
-    state(std::move(state))
+    state(std::move(state)),
+    subscription(0)
 {}
 
 template<class Session>
 basic_receiver_t<Session>::~basic_receiver_t() {
+    if (token) {
+        token->unsubscribe(subscription);
+    }
+
+    if (timer) {
+        timer->cancel();
+    }
+
     CF_DBG("revoking ...");
     session->revoke(id);
 }
@@ -40,6 +74,97 @@ basic_receiver_t<Session>::recv() {
     return state->get();
 }
 
+template<class Session>
+task<decoded_message>::future_type
+basic_receiver_t<Session>::recv(deadline_t deadline) {
+    auto future = state->get();
+    if (future.ready()) {
+        return future;
+    }
+
+    std::weak_ptr<Session> session(this->session);
+    std::weak_ptr<shared_state_t> state(this->state);
+    const auto id = this->id;
+
+    auto timer = this->session->timers().schedule(deadline.time_point(), [session, state, id] {
+        abandon(session, state, id, asio::error::timed_out);
+    });
+
+    return future.then([timer](task<decoded_message>::future_move_type future) -> decoded_message {
+        timer->cancel();
+        return future.get();
+    });
+}
+
+template<class Session>
+task<std::vector<decoded_message>>::future_type
+basic_receiver_t<Session>::recv_many(std::size_t max) {
+    BOOST_ASSERT(max > 0);
+
+    std::vector<decoded_message> messages;
+    state->take(messages, max);
+
+    if (!messages.empty()) {
+        return make_ready_future<std::vector<decoded_message>>::value(std::move(messages));
+    }
+
+    // Nothing is buffered, so wait for the next message and take ones arrived with it.
+    auto state = this->state;
+    return state->get().then([state, max](task<decoded_message>::future_move_type future) -> std::vector<decoded_message> {
+        std::vector<decoded_message> messages;
+        messages.push_back(future.get());
+        state->take(messages, max);
+        return messages;
+    });
+}
+
+template<class Session>
+void
+basic_receiver_t<Session>::cancel() {
+    CF_DBG("cancelling ...");
+    state->cancel(asio::error::operation_aborted);
+    session->revoke(id);
+}
+
+template<class Session>
+void
+basic_receiver_t<Session>::bind(cancellation_token_t token) {
+    BOOST_ASSERT(!this->token);
+
+    // The token may outlive the receiver, so it must not prolong the lifetime of the channel.
+    std::weak_ptr<Session> session(this->session);
+    std::weak_ptr<shared_state_t> state(this->state);
+    const auto id = this->id;
+
+    this->token = token;
+    subscription = this->token->subscribe([session, state, id] {
+        abandon(session, state, id, asio::error::operation_aborted);
+    });
+}
+
+template<class Session>
+void
+basic_receiver_t<Session>::expire(deadline_t deadline) {
+    BOOST_ASSERT(!timer);
+
+    std::weak_ptr<Session> session(this->session);
+    std::weak_ptr<shared_state_t> state(this->state);
+    const auto id = this->id;
+
+    timer = this->session->timers().schedule(deadline.time_point(), [session, state, id] {
+        abandon(session, state, id, asio::error::timed_out);
+    });
+}
+
+template<class Session>
+void
+basic_receiver_t<Session>::subscribe(executor_t executor,
+                                     std::function<void(decoded_message&&)> on_message,
+                                     std::function<void(const std::error_code&)> on_error)
+{
+    state->subscribe(std::move(executor), std::move(on_message), std::move(on_error));
+}
+
 template<class Session>
 cocaine::trace_t
 basic_receiver_t<Session>::get_trace() const {
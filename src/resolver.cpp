@@ -96,44 +96,99 @@ on_connect(task<void>::future_move_type future, std::shared_ptr<framework::sessi
 } // namespace
 
 resolver_t::resolver_t(scheduler_t& scheduler) :
-    scheduler(scheduler)
-{
-    endpoints_.emplace_back(boost::asio::ip::tcp::v6(), 10053);
-}
+    scheduler(scheduler),
+    endpoints_({ endpoint_type(boost::asio::ip::tcp::v6(), 10053) })
+{}
 
 resolver_t::~resolver_t() {}
 
 std::vector<resolver_t::endpoint_type> resolver_t::endpoints() const {
+    std::lock_guard<std::mutex> lock(mutex);
     return endpoints_;
 }
 
 void resolver_t::endpoints(std::vector<resolver_t::endpoint_type> endpoints) {
+    std::lock_guard<std::mutex> lock(mutex);
     endpoints_ = std::move(endpoints);
+    locator_.reset();
+}
+
+void resolver_t::locator(std::shared_ptr<session_t> locator) {
+    std::lock_guard<std::mutex> lock(mutex);
+    locator_ = std::move(locator);
 }
 
 auto resolver_t::resolve(std::string name) -> task<resolver_t::result_t>::future_type {
     CF_CTX("R");
 
-    auto locator = std::make_shared<framework::session_t>(scheduler);
-    locator->hard_shutdown(true);
+    std::shared_ptr<framework::session_t> locator;
+    std::vector<endpoint_type> endpoints;
+    {
+        // The private session is created on the first resolve only, so that resolvers given a
+        // shared one don't allocate it at all.
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!locator_) {
+            locator_ = std::make_shared<framework::session_t>(scheduler);
+            locator_->hard_shutdown(true);
+        }
+
+        locator = locator_;
+        endpoints = endpoints_;
+    }
 
-    CF_DBG(">> connecting to the locator ...");
-    return locator->connect(endpoints())
+    auto connected = make_ready_future<void>::value();
+    if (!locator->connected()) {
+        // Concurrent resolves are queued by the session until the connection is established.
+        CF_DBG(">> connecting to the locator ...");
+        connected = locator->connect(endpoints);
+    }
+
+    return connected
         .then(scheduler, trace::wrap(trace_t::bind(&on_connect, ph::_1, locator, name)))
         .then(scheduler, trace::wrap(trace_t::bind(&on_invoke, ph::_1, locator)))
         .then(scheduler, trace::wrap(trace_t::bind(&on_resolve, ph::_1, locator, name)));
 }
 
+const serialized_resolver_t::clock_type::duration serialized_resolver_t::default_ttl =
+    std::chrono::seconds(30);
+
 serialized_resolver_t::serialized_resolver_t(std::vector<endpoint_type> endpoints, scheduler_t& scheduler) :
     resolver(scheduler),
-    scheduler(scheduler)
+    scheduler(scheduler),
+    ttl_(default_ttl)
 {
     resolver.endpoints(std::move(endpoints));
 }
 
+void serialized_resolver_t::locator(std::shared_ptr<session_t> locator) {
+    resolver.locator(std::move(locator));
+}
+
+void serialized_resolver_t::ttl(clock_type::duration ttl) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ttl_ = ttl;
+}
+
 auto serialized_resolver_t::resolve(std::string name) -> task<result_type>::future_type {
     std::unique_lock<std::mutex> lock(mutex);
 
+    auto cached = cache.find(name);
+    if (cached != cache.end()) {
+        auto result = cached->second.result;
+
+        if (cached->second.expires <= clock_type::now() && inprogress.count(name) == 0) {
+            CF_DBG("refreshing stale '%s' service resolve result", name.c_str());
+
+            // Nobody waits for the refresh, the result is just put into the cache.
+            inprogress.insert(std::make_pair(name, std::deque<task<result_type>::promise_type>()));
+            lock.unlock();
+            resolver.resolve(name)
+                .then(scheduler, trace::wrap(trace_t::bind(&serialized_resolver_t::notify_all, shared_from_this(), ph::_1, name)));
+        }
+
+        return make_ready_future<result_type>::value(std::move(result));
+    }
+
     auto it = inprogress.find(name);
     if (it == inprogress.end()) {
         std::deque<task<result_type>::promise_type> queue;
@@ -160,16 +215,38 @@ serialized_resolver_t::notify_all(task<result_type>::future_move_type future, st
 
     try {
         auto result = future.get();
+
+        if (ttl_ > clock_type::duration::zero()) {
+            cache[name] = entry_t { result, clock_type::now() + ttl_ };
+        }
+
         for (auto& promise : it->second) {
             promise.set_value(result);
         }
         inprogress.erase(it);
         return result;
-    } catch (const std::system_error& err) {
+    } catch (...) {
+        // A failed background refresh keeps serving the stale result, which is dropped only when
+        // it's explicitly invalidated.
         for (auto& promise : it->second) {
-            promise.set_exception(err);
+            promise.set_exception(std::current_exception());
         }
         inprogress.erase(it);
         throw;
     }
 }
+
+void serialized_resolver_t::invalidate(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    cache.erase(name);
+}
+
+void serialized_resolver_t::update(const std::string& name, const result_type& result) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (result.endpoints.empty() || ttl_ <= clock_type::duration::zero()) {
+        cache.erase(name);
+    } else {
+        cache[name] = entry_t { result, clock_type::now() + ttl_ };
+    }
+}
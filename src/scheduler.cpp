@@ -22,6 +22,6 @@ using namespace cocaine::framework;
 
 void
 scheduler_t::operator()(closure_type fn) {
-    ev.userloop.post(std::move(fn));
+    ev.userloop.post(detail::closure_handler_t(std::move(fn)));
 }
 
@@ -31,6 +31,6 @@ basic_sender_t<Session>::basic_sender_t(std::uint64_t id, std::shared_ptr<sessio
 
 template<class Session>
 task<void>::future_type
-basic_sender_t<Session>::send(io::encoder_t::message_type&& message) {
-    return session->push(std::move(message));
+basic_sender_t<Session>::send(encode_ref_t encode) {
+    return session->push(id, encode);
 }
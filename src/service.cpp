@@ -16,7 +16,14 @@
 
 #include "cocaine/framework/service.hpp"
 
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+
 #include "cocaine/framework/detail/basic_session.hpp"
+#include "cocaine/framework/detail/discovery.hpp"
 #include "cocaine/framework/detail/log.hpp"
 #include "cocaine/framework/detail/resolver.hpp"
 #include "cocaine/framework/trace.hpp"
@@ -28,55 +35,252 @@ using namespace cocaine::framework::detail;
 
 namespace {
 
+/// Rotates the given endpoints by the given offset, so that pooled sessions start connecting from
+/// different endpoints.
+std::vector<session_t::endpoint_type>
+spread(std::vector<session_t::endpoint_type> endpoints, std::size_t offset) {
+    if (!endpoints.empty()) {
+        std::rotate(endpoints.begin(), endpoints.begin() + offset % endpoints.size(), endpoints.end());
+    }
+
+    return endpoints;
+}
+
 task<void>::future_type
-on_resolve(task<resolver_t::result_t>::future_move_type future, uint version, std::shared_ptr<session_t> session) {
+on_resolve(task<resolver_t::result_t>::future_move_type future, uint version, std::shared_ptr<session_t> session, std::size_t offset) {
     auto info = future.get();
     if (version != info.version) {
         return make_ready_future<void>::error(version_mismatch(version, info.version));
     }
 
-    return session->connect(info.endpoints);
+    return session->connect(spread(std::move(info.endpoints), offset));
 }
 
 void
-on_connect(task<void>::future_move_type future) {
+on_connect(task<void>::future_move_type future, std::shared_ptr<serialized_resolver_t> resolver, std::string name) {
     try {
         future.get();
         CF_DBG("<< connected");
     } catch (const std::exception& err) {
         CF_DBG("<< failed to connect: %s", err.what());
+
+        // Endpoints cached may have gone, so the next attempt must ask the locator.
+        resolver->invalidate(name);
         throw;
     }
 }
 
+/// Connection attempts of pooled sessions, which succeed as soon as any of them succeeds, or fail
+/// with the first error after all of them have failed.
+struct connect_any_t {
+    std::size_t pending;
+    bool done;
+    std::exception_ptr error;
+    std::mutex mutex;
+    task<void>::promise_type promise;
+
+    explicit
+    connect_any_t(std::size_t pending) :
+        pending(pending),
+        done(false)
+    {}
+
+    void
+    on_connect(task<void>::future_move_type future) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        try {
+            future.get();
+
+            if (!done) {
+                done = true;
+                promise.set_value();
+            }
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+
+            if (--pending == 0 && !done) {
+                done = true;
+                promise.set_exception(error);
+            }
+        }
+    }
+};
+
 } // namespace
 
-class basic_service_t::impl {
+class basic_service_t::impl : public watcher_t, public std::enable_shared_from_this<impl> {
 public:
-    std::string name;
+    std::string name_;
     uint version;
     scheduler_t& scheduler;
     std::shared_ptr<serialized_resolver_t> resolver;
+
+    /// Pooled sessions, there is always at least one.
+    std::vector<std::shared_ptr<session_t>> sessions;
+    bool hard_shutdown;
+
+    /// Incremented on each move to other endpoints, so that only the latest one replaces the
+    /// sessions.
+    std::uint64_t generation;
+
+    /// The number of connection attempts made, which is used to spread sessions across endpoints.
+    std::size_t connects;
+
+    std::minstd_rand random;
     std::mutex mutex;
 
     impl(std::string name, uint version, endpoints_t locations, scheduler_t& scheduler) :
-        name(std::move(name)),
+        name_(std::move(name)),
         version(version),
         scheduler(scheduler),
-        resolver(std::make_shared<serialized_resolver_t>(std::move(locations), scheduler))
+        resolver(std::make_shared<serialized_resolver_t>(std::move(locations), scheduler)),
+        sessions(1, std::make_shared<session_t>(scheduler)),
+        hard_shutdown(false),
+        generation(0),
+        connects(0),
+        random(std::random_device()())
     {}
+
+    auto
+    name() const -> const std::string& {
+        return name_;
+    }
+
+    void
+    update(const resolver_t::result_t& result);
+
+    /// Returns the less loaded of two distinct random sessions by the number of invocations in
+    /// flight, preferring the connected one if the other is not.
+    ///
+    /// The disconnected session losing is passed through the given pointer, so that it could be
+    /// reconnected in the background.
+    ///
+    /// \warning call only with the lock held.
+    auto
+    select(std::shared_ptr<session_t>& idle) -> std::shared_ptr<session_t>;
 };
 
+void basic_service_t::impl::update(const resolver_t::result_t& result) {
+    resolver->update(name_, result);
+
+    if (result.endpoints.empty() || result.version != version) {
+        // Nowhere to move, sessions are left to fail by themselves.
+        return;
+    }
+
+    // The session moved is held weakly, so that the move does not prolong its life.
+    struct move_t {
+        std::size_t slot;
+        std::weak_ptr<session_t> stale;
+        std::shared_ptr<session_t> fresh;
+    };
+
+    std::vector<move_t> moves;
+    std::uint64_t id;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (std::size_t slot = 0; slot < sessions.size(); ++slot) {
+            const auto& session = sessions[slot];
+
+            // Disconnected sessions connect to the new endpoints anyway, as they are already
+            // cached.
+            if (!session->connected()) {
+                continue;
+            }
+
+            const auto endpoint = session->endpoint();
+            if (endpoint && std::find(result.endpoints.begin(), result.endpoints.end(), *endpoint) != result.endpoints.end()) {
+                continue;
+            }
+
+            auto fresh = std::make_shared<session_t>(scheduler);
+            fresh->hard_shutdown(hard_shutdown);
+            moves.push_back(move_t { slot, session, std::move(fresh) });
+        }
+
+        if (moves.empty()) {
+            return;
+        }
+
+        id = ++generation;
+    }
+
+    CF_DBG(">> moving '%s' service to new endpoints ...", name_.c_str());
+
+    std::weak_ptr<impl> weak(shared_from_this());
+
+    for (const auto& move : moves) {
+        const auto slot = move.slot;
+        const auto stale = move.stale;
+        const auto fresh = move.fresh;
+
+        fresh->connect(spread(result.endpoints, slot)).then(scheduler, [weak, stale, fresh, slot, id](task<void>::future_move_type future) {
+            try {
+                future.get();
+            } catch (const std::exception& err) {
+                // The current session is kept until it fails as usual.
+                CF_DBG("<< failed to move: %s", err.what());
+                return;
+            }
+
+            if (auto self = weak.lock()) {
+                // The old session is released without holding the lock, and closes its
+                // connection after all its channels are done, unless the hard shutdown is set.
+                std::shared_ptr<session_t> old;
+
+                // The pool may have been shrunk and grown again meanwhile, leaving an unrelated
+                // session in the slot, which must not be replaced.
+                std::lock_guard<std::mutex> lock(self->mutex);
+                if (self->generation == id && slot < self->sessions.size() && self->sessions[slot] == stale.lock()) {
+                    CF_DBG("<< moved");
+                    old = std::move(self->sessions[slot]);
+                    self->sessions[slot] = fresh;
+                }
+            }
+        });
+    }
+}
+
+auto basic_service_t::impl::select(std::shared_ptr<session_t>& idle) -> std::shared_ptr<session_t> {
+    if (sessions.size() == 1) {
+        return sessions.front();
+    }
+
+    std::uniform_int_distribution<std::size_t> first(0, sessions.size() - 1);
+    std::uniform_int_distribution<std::size_t> offset(1, sessions.size() - 1);
+
+    const auto id = first(random);
+    const auto& one = sessions[id];
+    const auto& other = sessions[(id + offset(random)) % sessions.size()];
+
+    // A dropped session has no invocations in flight, but choosing it would make the invocation
+    // wait for reconnecting, or fail if the endpoint has gone.
+    const bool connected = one->connected();
+    if (connected != other->connected()) {
+        idle = connected ? other : one;
+        return connected ? one : other;
+    }
+
+    if (other->inflight() < one->inflight()) {
+        return other;
+    }
+
+    return one;
+}
+
 basic_service_t::basic_service_t(internal_logger_t logger_, std::string name, uint version, endpoints_t locations, scheduler_t& scheduler) :
-    d(new impl(std::move(name), version, std::move(locations), scheduler)),
-    session(std::make_shared<session_t>(scheduler)),
+    d(std::make_shared<impl>(std::move(name), version, std::move(locations), scheduler)),
     scheduler(scheduler),
     logger(std::move(logger_))
 {}
 
 basic_service_t::basic_service_t(basic_service_t&& other) :
     d(std::move(other.d)),
-    session(std::move(other.session)),
     scheduler(other.scheduler),
     logger(std::move(other.logger))
 {}
@@ -85,7 +289,7 @@ basic_service_t::~basic_service_t() {}
 
 const std::string&
 basic_service_t::name() const noexcept {
-    return d->name;
+    return d->name_;
 }
 
 uint
@@ -94,15 +298,97 @@ basic_service_t::version() const noexcept {
 }
 
 auto basic_service_t::hard_shutdown(bool policy) -> void {
-    session->hard_shutdown(policy);
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->hard_shutdown = policy;
+
+    for (const auto& session : d->sessions) {
+        session->hard_shutdown(policy);
+    }
+}
+
+auto basic_service_t::resolve_ttl(std::chrono::milliseconds ttl) -> void {
+    d->resolver->ttl(ttl);
+}
+
+auto basic_service_t::pool(std::size_t size) -> void {
+    if (size == 0) {
+        throw std::invalid_argument("pool size must be a positive number");
+    }
+
+    // Sessions dropped are released without holding the lock.
+    std::vector<std::shared_ptr<session_t>> dropped;
+
+    std::lock_guard<std::mutex> lock(d->mutex);
+
+    while (d->sessions.size() > size) {
+        dropped.push_back(std::move(d->sessions.back()));
+        d->sessions.pop_back();
+    }
+
+    while (d->sessions.size() < size) {
+        auto session = std::make_shared<session_t>(d->scheduler);
+        session->hard_shutdown(d->hard_shutdown);
+        d->sessions.push_back(std::move(session));
+    }
 }
 
 cocaine::framework::future<void>
 basic_service_t::connect() {
-    CF_CTX("SC");
-    CF_DBG(">> connecting ...");
+    std::vector<std::shared_ptr<session_t>> sessions;
+
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        sessions = d->sessions;
+    }
+
+    if (sessions.size() == 1) {
+        return connect(sessions.front());
+    }
+
+    auto state = std::make_shared<connect_any_t>(sessions.size());
+    auto future = state->promise.get_future();
+
+    for (const auto& session : sessions) {
+        connect(session)
+            .then(trace::wrap(trace_t::bind(&connect_any_t::on_connect, state, ph::_1)));
+    }
+
+    return future;
+}
 
+boost::optional<session_t::endpoint_type>
+basic_service_t::endpoint() const {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    return d->sessions.front()->endpoint();
+}
+
+basic_service_t::native_handle_type
+basic_service_t::native_handle() const {
     std::lock_guard<std::mutex> lock(d->mutex);
+    return d->sessions.front()->native_handle();
+}
+
+auto basic_service_t::select() -> std::shared_ptr<session_t> {
+    std::shared_ptr<session_t> session;
+    std::shared_ptr<session_t> idle;
+
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        session = d->select(idle);
+    }
+
+    if (idle) {
+        // The dropped session joins the balancing again after it is reconnected.
+        connect(std::move(idle));
+    }
+
+    return session;
+}
+
+cocaine::framework::future<void>
+basic_service_t::connect(std::shared_ptr<session_t> session) {
+    CF_CTX("SC");
+    CF_DBG(">> connecting ...");
 
     // Internally the session manages with connection state itself. On any network error it
     // should drop its internal state and return false.
@@ -111,17 +397,22 @@ basic_service_t::connect() {
         return make_ready_future<void>::value();
     }
 
-    return d->resolver->resolve(d->name)
-        .then(trace::wrap(trace_t::bind(&::on_resolve, ph::_1, d->version, session)))
-        .then(trace::wrap(trace_t::bind(&::on_connect, ph::_1)));
+    std::size_t offset;
+
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        offset = d->connects++;
+    }
+
+    return d->resolver->resolve(d->name_)
+        .then(trace::wrap(trace_t::bind(&::on_resolve, ph::_1, d->version, session, offset)))
+        .then(trace::wrap(trace_t::bind(&::on_connect, ph::_1, d->resolver, d->name_)));
 }
 
-boost::optional<session_t::endpoint_type>
-basic_service_t::endpoint() const {
-    return session->endpoint();
+auto basic_service_t::watcher() const -> std::shared_ptr<watcher_t> {
+    return d;
 }
 
-basic_service_t::native_handle_type
-basic_service_t::native_handle() const {
-    return session->native_handle();
+void basic_service_t::locator(std::shared_ptr<session_t> locator) {
+    d->resolver->locator(std::move(locator));
 }
@@ -42,7 +42,17 @@ public:
     synchronized<std::vector<endpoint_type>> endpoints;
 
     typedef std::vector<std::shared_ptr<task<void>::promise_type>> queue_type;
-    synchronized<queue_type> queue;
+
+    /// Connection attempts, which are made one at a time, while other callers wait for the
+    /// current one to complete.
+    struct pending_t {
+        bool connecting;
+        queue_type queue;
+
+        pending_t() : connecting(false) {}
+    };
+
+    synchronized<pending_t> pending;
 
     explicit impl(scheduler_t& scheduler) :
         scheduler(scheduler),
@@ -50,34 +60,25 @@ public:
     {}
 
     /// \warning call only from event loop thread, otherwise the behavior is undefined.
-    void on_connect(task<std::error_code>::future_move_type future, std::shared_ptr<task<void>::promise_type> promise) {
+    void on_connect(task<std::error_code>::future_move_type future) {
         const auto ec = future.get();
 
-        if (ec) {
-            switch (ec.value()) {
-            case asio::error::already_started:
-                queue->push_back(promise);
-                break;
-            case asio::error::already_connected:
-                promise->set_value();
-                break;
-            default:
-                promise->set_exception(std::system_error(ec));
-                queue.apply([&](queue_type& queue) {
-                    for (auto it = queue.begin(); it != queue.end(); ++it) {
-                        (*it)->set_exception(std::system_error(ec));
-                    }
-                    queue.clear();
-                });
+        // Waiters are taken at once with the attempt marked as completed, so that none of the
+        // concurrent callers is left in the queue after it is drained.
+        queue_type queue;
+        pending.apply([&](pending_t& pending) {
+            queue.swap(pending.queue);
+            pending.connecting = false;
+        });
+
+        if (!ec || ec.value() == asio::error::already_connected) {
+            for (auto it = queue.begin(); it != queue.end(); ++it) {
+                (*it)->set_value();
             }
         } else {
-            promise->set_value();
-            queue.apply([&](queue_type& queue) {
-                for (auto it = queue.begin(); it != queue.end(); ++it) {
-                    (*it)->set_value();
-                }
-                queue.clear();
-            });
+            for (auto it = queue.begin(); it != queue.end(); ++it) {
+                (*it)->set_exception(std::system_error(ec));
+            }
         }
     }
 };
@@ -98,6 +99,11 @@ bool session<BasicSession>::connected() const {
     return d->sess->connected();
 }
 
+template<class BasicSession>
+auto session<BasicSession>::inflight() const -> std::size_t {
+    return d->sess->inflight();
+}
+
 template<class BasicSession>
 auto session<BasicSession>::connect(const session::endpoint_type& endpoint) -> task<void>::future_type {
     return connect(std::vector<endpoint_type> {{ endpoint }});
@@ -114,8 +120,21 @@ auto session<BasicSession>::connect(const std::vector<session::endpoint_type>& e
     auto promise = std::make_shared<task<void>::promise_type>();
     auto future = promise->get_future();
 
-    d->sess->connect(endpoints)
-        .then(d->scheduler, trace::wrap(trace_t::bind(&impl::on_connect, d, ph::_1, promise)));
+    const bool first = d->pending.apply([&](typename impl::pending_t& pending) -> bool {
+        pending.queue.push_back(promise);
+
+        if (pending.connecting) {
+            return false;
+        }
+
+        pending.connecting = true;
+        return true;
+    });
+
+    if (first) {
+        d->sess->connect(endpoints)
+            .then(d->scheduler, trace::wrap(trace_t::bind(&impl::on_connect, d, ph::_1)));
+    }
 
     return future;
 }
@@ -137,10 +156,24 @@ session<BasicSession>::native_handle() const {
 }
 
 template<class BasicSession>
-auto session<BasicSession>::invoke(encode_callback_t encode_callback)
+auto session<BasicSession>::invoke(encode_ref_t encode)
+    -> task<basic_invoke_result>::future_type
+{
+    return d->sess->invoke(encode);
+}
+
+template<class BasicSession>
+auto session<BasicSession>::invoke(encode_ref_t encode, cancellation_token_t token)
+    -> task<basic_invoke_result>::future_type
+{
+    return d->sess->invoke(encode, std::move(token));
+}
+
+template<class BasicSession>
+auto session<BasicSession>::invoke(encode_ref_t encode, deadline_t deadline)
     -> task<basic_invoke_result>::future_type
 {
-    return d->sess->invoke(std::move(encode_callback));
+    return d->sess->invoke(encode, deadline);
 }
 
 #include "cocaine/framework/detail/basic_session.hpp"
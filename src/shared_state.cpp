@@ -16,52 +16,342 @@
 
 #include "cocaine/framework/detail/shared_state.hpp"
 
+#include <thread>
+
+#include <boost/assert.hpp>
+
+#include <cocaine/locked_ptr.hpp>
+
 using namespace cocaine::framework;
 
+struct shared_state_t::subscriber_t {
+    executor_t executor;
+    std::function<void(value_type&&)> on_message;
+    std::function<void(const std::error_code&)> on_error;
+
+    /// Messages and the error waiting to be delivered on the executor.
+    struct mailbox_t {
+        std::vector<value_type> messages;
+        boost::optional<std::error_code> error;
+        /// Whether a drain is posted and has not seen the mailbox empty yet.
+        bool scheduled;
+
+        mailbox_t() :
+            scheduled(false)
+        {}
+    };
+
+    synchronized<mailbox_t> mailbox;
+
+    subscriber_t(executor_t executor,
+                 std::function<void(value_type&&)> on_message,
+                 std::function<void(const std::error_code&)> on_error) :
+        executor(std::move(executor)),
+        on_message(std::move(on_message)),
+        on_error(std::move(on_error))
+    {}
+};
+
+namespace {
+
+/// Delivers batches of messages from the subscriber mailbox on the executor, until it is empty.
+///
+/// At most one drain per subscriber is posted at a time, so handlers are never called
+/// concurrently and keep the order of messages, even on a multithreaded executor.
+template<class Subscriber>
+struct drain_t {
+    std::shared_ptr<Subscriber> subscriber;
+
+    void
+    operator()() {
+        typedef typename Subscriber::mailbox_t mailbox_t;
+
+        std::vector<decoded_message> batch;
+        boost::optional<std::error_code> error;
+
+        for (;;) {
+            subscriber->mailbox.apply([&](mailbox_t& mailbox) {
+                // Swapping keeps both vectors' storage for further batches.
+                batch.swap(mailbox.messages);
+                error.swap(mailbox.error);
+                mailbox.scheduled = !batch.empty() || error;
+            });
+
+            if (batch.empty() && !error) {
+                return;
+            }
+
+            for (auto& message : batch) {
+                subscriber->on_message(std::move(message));
+            }
+
+            batch.clear();
+
+            if (error) {
+                // Nothing is delivered after the error, so the drain stays scheduled forever.
+                subscriber->on_error(*error);
+                return;
+            }
+        }
+    }
+};
+
+} // namespace
+
 void shared_state_t::put(value_type&& message) {
-    std::unique_lock<std::mutex> lock(mutex);
+    if (status.load(std::memory_order_acquire) != intact) {
+        // The channel has been cancelled, while the message was being dispatched.
+        return;
+    }
 
-    BOOST_ASSERT(!broken);
+    queue.push(std::move(message));
+    notify();
+}
 
-    if (await.empty()) {
-        queue.push(std::move(message));
+void shared_state_t::put(const std::error_code& ec) {
+    int expected = intact;
+    if (!status.compare_exchange_strong(expected, breaking, std::memory_order_acquire)) {
+        return;
+    }
+
+    error = ec;
+    status.store(broken, std::memory_order_release);
+    notify();
+}
+
+auto shared_state_t::get() -> task<value_type>::future_type {
+    // Without waiters nobody but the consumer pops messages, so buffered ones are received without
+    // taking the busy flag.
+    if ((state.load(std::memory_order_acquire) & (busy | armed)) == 0) {
+        if (is_broken()) {
+            while (queue.pop()) {}
+            return make_ready_future<value_type>::error(std::system_error(error));
+        }
+
+        if (auto message = queue.pop()) {
+            return make_ready_future<value_type>::value(std::move(*message));
+        }
+    }
+
+    lock();
+
+    BOOST_ASSERT(!subscriber);
+
+    if (is_broken()) {
+        unlock();
+        return make_ready_future<value_type>::error(std::system_error(error));
+    }
+
+    if (!waiter) {
+        if (auto message = queue.pop()) {
+            unlock();
+            return make_ready_future<value_type>::value(std::move(*message));
+        }
+    }
+
+    promise_type promise;
+    auto future = promise.get_future();
+
+    if (waiter) {
+        waiters.push_back(std::move(promise));
     } else {
-        auto promise = await.front();
-        await.pop();
-        lock.unlock();
+        waiter = std::move(promise);
+    }
+
+    unlock();
+    return future;
+}
+
+void shared_state_t::take(std::vector<value_type>& messages, std::size_t max) {
+    // The same as for get(), the flag is required only if someone else may pop messages.
+    const auto owned = (state.load(std::memory_order_acquire) & (busy | armed)) == 0;
+
+    if (!owned) {
+        lock();
+    }
+
+    BOOST_ASSERT(!subscriber);
+
+    if (!waiter && !is_broken()) {
+        while (messages.size() < max) {
+            auto message = queue.pop();
+            if (!message) {
+                break;
+            }
 
-        promise.set_value(std::move(message));
+            messages.push_back(std::move(*message));
+        }
+    }
+
+    if (!owned) {
+        unlock();
     }
 }
 
-void shared_state_t::put(const std::error_code& ec) {
-    std::unique_lock<std::mutex> lock(mutex);
+void shared_state_t::cancel(const std::error_code& ec) {
+    // Buffered messages belong to the consumer, which drops them on its next receive attempt.
+    put(ec);
+}
+
+void shared_state_t::subscribe(executor_t executor,
+                               std::function<void(value_type&&)> on_message,
+                               std::function<void(const std::error_code&)> on_error)
+{
+    lock();
+
+    BOOST_ASSERT(!waiter && !subscriber);
+
+    subscriber = std::make_shared<subscriber_t>(
+        std::move(executor),
+        std::move(on_message),
+        std::move(on_error)
+    );
+
+    unlock();
+}
+
+void shared_state_t::notify() {
+    auto current = state.fetch_or(dirty, std::memory_order_acq_rel) | dirty;
 
-    BOOST_ASSERT(!broken);
+    // Either the holder rechecks the state before leaving, or there is nobody to complete.
+    while (current == (armed | dirty)) {
+        if (state.compare_exchange_weak(current, busy, std::memory_order_acquire)) {
+            unlock();
+            return;
+        }
+    }
+}
 
-    broken = ec;
-    std::queue<task<value_type>::promise_type> await(std::move(this->await));
-    lock.unlock();
+void shared_state_t::lock() {
+    auto current = state.load(std::memory_order_relaxed);
 
-    while (!await.empty()) {
-        await.front().set_exception(std::system_error(ec));
-        await.pop();
+    for (;;) {
+        if (current & busy) {
+            std::this_thread::yield();
+            current = state.load(std::memory_order_relaxed);
+        } else if (state.compare_exchange_weak(current, busy, std::memory_order_acquire)) {
+            return;
+        }
     }
 }
 
-auto shared_state_t::get() -> task<value_type>::future_type {
-    std::lock_guard<std::mutex> lock(mutex);
+void shared_state_t::unlock() {
+    for (;;) {
+        boost::optional<promise_type> promise;
+        boost::optional<value_type> message;
+        std::vector<promise_type> failed;
+
+        if (subscriber) {
+            dispatch();
+        } else if (waiter) {
+            if (is_broken()) {
+                promise = std::move(waiter);
+                waiter = boost::none;
+                failed.swap(waiters);
+            } else if ((message = queue.pop())) {
+                promise = std::move(waiter);
+                waiter = boost::none;
+
+                if (!waiters.empty()) {
+                    waiter = std::move(waiters.front());
+                    waiters.erase(waiters.begin());
+                }
+            }
+        }
+
+        const int next = waiter || subscriber ? armed : 0;
+
+        int current = busy;
+        if (!state.compare_exchange_strong(current, next, std::memory_order_release)) {
+            // Something has arrived meanwhile. Nothing is completed while the flag is held,
+            // because continuations are free to receive from this state again.
+            if (!promise) {
+                state.exchange(busy, std::memory_order_acq_rel);
+                continue;
+            }
+
+            current = next | dirty;
+            state.exchange(current, std::memory_order_acq_rel);
+        }
+
+        if (promise) {
+            if (message) {
+                promise->set_value(std::move(*message));
+            } else {
+                promise->set_exception(std::system_error(error));
+            }
+        }
+
+        for (auto& promise : failed) {
+            promise.set_exception(std::system_error(error));
+        }
+
+        if (current != (armed | dirty) || !state.compare_exchange_strong(current, busy, std::memory_order_acquire)) {
+            return;
+        }
+    }
+}
+
+void shared_state_t::dispatch() {
+    if (subscriber->executor) {
+        post();
+        return;
+    }
+
+    // Handlers are called with the busy flag held, which keeps them ordered. Nobody receives from
+    // the state in the push mode and put() never waits for the flag, so this can't deadlock.
+    while (!is_broken()) {
+        auto message = queue.pop();
+        if (!message) {
+            return;
+        }
+
+        subscriber->on_message(std::move(*message));
+    }
+
+    while (queue.pop()) {}
+
+    auto subscriber = std::move(this->subscriber);
+    subscriber->on_error(error);
+}
+
+void shared_state_t::post() {
+    const auto broken = is_broken();
+
+    const bool schedule = subscriber->mailbox.apply([&](subscriber_t::mailbox_t& mailbox) -> bool {
+        while (!broken) {
+            auto message = queue.pop();
+            if (!message) {
+                break;
+            }
+
+            mailbox.messages.push_back(std::move(*message));
+        }
+
+        if (broken) {
+            mailbox.error = error;
+        }
+
+        if (mailbox.scheduled || (mailbox.messages.empty() && !mailbox.error)) {
+            return false;
+        }
+
+        mailbox.scheduled = true;
+        return true;
+    });
+
+    auto subscriber = this->subscriber;
 
     if (broken) {
-        return make_ready_future<value_type>::error(std::system_error(broken.get()));
+        while (queue.pop()) {}
+        this->subscriber.reset();
     }
 
-    if (queue.empty()) {
-        await.push(task<value_type>::promise_type());
-        return await.back().get_future();
+    if (schedule) {
+        subscriber->executor(drain_t<subscriber_t>{std::move(subscriber)});
     }
+}
 
-    auto future = make_ready_future<value_type>::value(std::move(queue.front()));
-    queue.pop();
-    return future;
+auto shared_state_t::is_broken() const -> bool {
+    return status.load(std::memory_order_acquire) == broken;
 }
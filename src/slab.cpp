@@ -0,0 +1,121 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/framework/detail/slab.hpp"
+
+#include <vector>
+
+#include <cocaine/locked_ptr.hpp>
+
+using namespace cocaine::framework::detail;
+
+namespace {
+
+/// The maximum number of free slabs kept for reuse.
+const std::size_t POOL_CAPACITY = 64;
+
+typedef cocaine::synchronized<std::vector<slab_t*>> pool_type;
+
+/// Returns the process-wide pool of free slabs.
+///
+/// \note the pool is intentionally leaked, because slabs may be released from static destructors.
+pool_type&
+pool() {
+    static pool_type* pool = new pool_type;
+    return *pool;
+}
+
+} // namespace
+
+const std::size_t slab_t::default_capacity;
+
+slab_t::slab_t(std::size_t capacity) :
+    refs(0),
+    capacity_(capacity),
+    data_(new char[capacity])
+{}
+
+auto
+slab_t::acquire(std::size_t capacity) -> slab_ptr {
+    if (capacity <= default_capacity) {
+        auto slab = pool().apply([](std::vector<slab_t*>& slabs) -> slab_t* {
+            if (slabs.empty()) {
+                return nullptr;
+            }
+
+            auto slab = slabs.back();
+            slabs.pop_back();
+            return slab;
+        });
+
+        if (slab) {
+            return slab_ptr(slab);
+        }
+
+        capacity = default_capacity;
+    }
+
+    return slab_ptr(new slab_t(capacity));
+}
+
+auto
+slab_t::data() noexcept -> char* {
+    return data_.get();
+}
+
+auto
+slab_t::capacity() const noexcept -> std::size_t {
+    return capacity_;
+}
+
+auto
+slab_t::unique() const noexcept -> bool {
+    return refs.load(std::memory_order_acquire) == 1;
+}
+
+void
+cocaine::framework::detail::intrusive_ptr_add_ref(slab_t* slab) noexcept {
+    slab->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+cocaine::framework::detail::intrusive_ptr_release(slab_t* slab) noexcept {
+    if (slab->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    if (slab->capacity() == slab_t::default_capacity) {
+        const bool pooled = pool().apply([&](std::vector<slab_t*>& slabs) -> bool {
+            if (slabs.size() >= POOL_CAPACITY) {
+                return false;
+            }
+
+            try {
+                slabs.push_back(slab);
+            } catch (const std::bad_alloc&) {
+                return false;
+            }
+
+            return true;
+        });
+
+        if (pooled) {
+            return;
+        }
+    }
+
+    delete slab;
+}
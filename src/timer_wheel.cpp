@@ -0,0 +1,263 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/framework/detail/timer_wheel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include <asio/steady_timer.hpp>
+
+#include <cocaine/locked_ptr.hpp>
+
+using namespace cocaine::framework::detail;
+
+const std::size_t timer_wheel_t::bits;
+const std::size_t timer_wheel_t::slots;
+const std::size_t timer_wheel_t::levels;
+
+class timer_wheel_t::impl :
+    public std::enable_shared_from_this<impl>
+{
+public:
+    typedef std::vector<handle_type> slot_type;
+
+    struct wheel_t {
+        std::array<std::array<slot_type, slots>, levels> data;
+        /// The last processed tick.
+        std::uint64_t now;
+        /// The number of timers stored in slots, including cancelled ones.
+        std::size_t size;
+        /// Whether the asio timer is armed or is going to be.
+        bool armed;
+
+        wheel_t() : now(0), size(0), armed(false) {}
+    };
+
+    loop_t& loop;
+    asio::steady_timer timer;
+
+    const clock_type::duration resolution;
+    const clock_type::time_point origin;
+
+    synchronized<wheel_t> wheel;
+
+    /// The number of pending timers, shared with timers themselves, which decrement it when they
+    /// are cancelled.
+    std::shared_ptr<std::atomic<std::size_t>> pending;
+
+    impl(loop_t& loop, clock_type::duration resolution) :
+        loop(loop),
+        timer(loop),
+        resolution(resolution),
+        origin(clock_type::now()),
+        pending(std::make_shared<std::atomic<std::size_t>>(0))
+    {}
+
+    /// Returns the number of the tick, which the given time point falls into.
+    auto
+    tick(clock_type::time_point time) const -> std::uint64_t {
+        if (time <= origin) {
+            return 0;
+        }
+
+        return static_cast<std::uint64_t>((time - origin) / resolution);
+    }
+
+    /// Arms the asio timer to fire at the beginning of the next tick.
+    ///
+    /// \warning call only from the event loop thread.
+    void
+    arm(std::uint64_t now) {
+        std::weak_ptr<impl> weak(shared_from_this());
+
+        timer.expires_at(origin + resolution * (now + 1));
+        timer.async_wait([weak](const std::error_code& ec) {
+            if (ec) {
+                return;
+            }
+
+            if (auto self = weak.lock()) {
+                self->on_timer();
+            }
+        });
+    }
+
+    void
+    on_timer() {
+        std::vector<handle_type> expired;
+
+        const auto target = tick(clock_type::now());
+
+        std::uint64_t now = 0;
+        const bool armed = wheel.apply([&](wheel_t& wheel) -> bool {
+            while (wheel.now < target) {
+                advance(wheel, expired);
+            }
+
+            now = wheel.now;
+
+            // Pending timers are counted under the lock by the scheduling thread, so none of the
+            // timers left can be pending once the counter drops to zero here. Timers expired but
+            // not called yet are still counted, which costs at most one extra tick.
+            if (*pending == 0) {
+                clear(wheel);
+            }
+
+            wheel.armed = wheel.size > 0;
+            return wheel.armed;
+        });
+
+        if (armed) {
+            arm(now);
+        }
+
+        for (auto& timer : expired) {
+            if (timer->complete()) {
+                auto callback = std::move(timer->callback);
+                callback();
+            }
+        }
+    }
+
+    /// Drops all timers from slots, which must be cancelled ones only.
+    static
+    void
+    clear(wheel_t& wheel) {
+        for (auto& level : wheel.data) {
+            for (auto& slot : level) {
+                for (auto& timer : slot) {
+                    timer->callback = nullptr;
+                }
+
+                slot.clear();
+            }
+        }
+
+        wheel.size = 0;
+    }
+
+    /// Moves the wheel by a single tick, collecting timers expired.
+    static
+    void
+    advance(wheel_t& wheel, std::vector<handle_type>& expired) {
+        ++wheel.now;
+
+        // Upper levels go first, because cascading timers may fall into lower slots that are
+        // coming up right now.
+        for (std::size_t level = levels - 1; level > 0; --level) {
+            const std::uint64_t mask = (std::uint64_t(1) << (bits * level)) - 1;
+            if ((wheel.now & mask) != 0) {
+                continue;
+            }
+
+            slot_type slot;
+            slot.swap(wheel.data[level][(wheel.now >> (bits * level)) & (slots - 1)]);
+
+            for (auto& timer : slot) {
+                if (timer->done) {
+                    timer->callback = nullptr;
+                    --wheel.size;
+                } else {
+                    insert(wheel, std::move(timer));
+                }
+            }
+        }
+
+        slot_type slot;
+        slot.swap(wheel.data[0][wheel.now & (slots - 1)]);
+
+        for (auto& timer : slot) {
+            if (timer->done) {
+                timer->callback = nullptr;
+                --wheel.size;
+            } else if (timer->expiry <= wheel.now) {
+                expired.push_back(std::move(timer));
+                --wheel.size;
+            } else {
+                // Timers beyond the last level turn around until they come into range.
+                insert(wheel, std::move(timer));
+            }
+        }
+    }
+
+    /// Puts the timer into the lowest level, which slots fit its expiration tick.
+    static
+    void
+    insert(wheel_t& wheel, handle_type timer) {
+        for (std::size_t level = 0; level < levels; ++level) {
+            const auto shift = bits * (level + 1);
+
+            if (level == levels - 1 || (timer->expiry >> shift) == (wheel.now >> shift)) {
+                wheel.data[level][(timer->expiry >> (bits * level)) & (slots - 1)].push_back(std::move(timer));
+                return;
+            }
+        }
+    }
+};
+
+timer_wheel_t::timer_wheel_t(loop_t& loop, clock_type::duration resolution) :
+    d(std::make_shared<impl>(loop, resolution))
+{}
+
+timer_wheel_t::~timer_wheel_t() {}
+
+auto
+timer_wheel_t::schedule(clock_type::time_point deadline, wheel_timer_t::callback_type callback) -> handle_type {
+    auto timer = std::make_shared<wheel_timer_t>(std::move(callback), d->pending);
+
+    // Round up, so that the timer never expires earlier.
+    const auto expiry = d->tick(deadline + d->resolution - clock_type::duration(1));
+
+    const bool arm = d->wheel.apply([&](impl::wheel_t& wheel) -> bool {
+        if (wheel.size == 0) {
+            // The wheel has been idle, so it's safe to skip all ticks passed.
+            wheel.now = std::max(wheel.now, d->tick(clock_type::now()));
+        }
+
+        timer->expiry = std::max(expiry, wheel.now + 1);
+        impl::insert(wheel, timer);
+        ++wheel.size;
+        ++*d->pending;
+
+        if (wheel.armed) {
+            return false;
+        }
+
+        wheel.armed = true;
+        return true;
+    });
+
+    if (arm) {
+        // Asio timers are not thread-safe, so the timer is armed from the event loop thread.
+        std::weak_ptr<impl> weak(d);
+        d->loop.post([weak] {
+            if (auto self = weak.lock()) {
+                self->arm(self->wheel.apply([](impl::wheel_t& wheel) -> std::uint64_t {
+                    return wheel.now;
+                }));
+            }
+        });
+    }
+
+    return timer;
+}
+
+auto
+timer_wheel_t::size() const -> std::size_t {
+    return *d->pending;
+}
@@ -65,6 +65,66 @@ auto on_recv_data(task<decoded_message>::future_move_type future) -> boost::opti
     return on_recv(future.get());
 }
 
+auto on_recv_many(task<std::vector<decoded_message>>::future_move_type future) -> std::vector<boost::optional<std::string>> {
+    const auto messages = future.get();
+
+    std::vector<boost::optional<std::string>> chunks;
+    chunks.reserve(messages.size());
+
+    for (const auto& message : messages) {
+        chunks.push_back(on_recv(message));
+    }
+
+    return chunks;
+}
+
+/// State of the callback-driven subscription.
+struct subscription_t {
+    stream_handlers<std::string> handlers;
+
+    /// Keeps the channel alive until it is either closed or failed.
+    std::shared_ptr<basic_receiver_t<worker_session_t>> session;
+};
+
+void on_stream_error(subscription_t& subscription, std::exception_ptr error) {
+    if (!subscription.session) {
+        return;
+    }
+
+    auto session = std::move(subscription.session);
+
+    if (subscription.handlers.error) {
+        subscription.handlers.error(error);
+    }
+}
+
+void on_stream_chunk(subscription_t& subscription, const decoded_message& message) {
+    if (!subscription.session) {
+        return;
+    }
+
+    boost::optional<std::string> chunk;
+    try {
+        chunk = on_recv(message);
+    } catch (...) {
+        on_stream_error(subscription, std::current_exception());
+        return;
+    }
+
+    if (chunk) {
+        if (subscription.handlers.chunk) {
+            subscription.handlers.chunk(std::move(*chunk));
+        }
+    } else {
+        // The channel is revoked after the close handler is called.
+        auto session = std::move(subscription.session);
+
+        if (subscription.handlers.close) {
+            subscription.handlers.close();
+        }
+    }
+}
+
 auto on_recv_with_meta(future<decoded_message>& future) -> boost::optional<frame_t> {
     const auto message = future.get();
     if (auto chunk = on_recv(message)) {
@@ -109,6 +169,26 @@ auto receiver::recv<frame_t>() -> future<boost::optional<frame_t>> {
         .then(std::bind(&on_recv_with_meta, ph::_1));
 }
 
+auto receiver::recv_many(std::size_t max) -> future<std::vector<boost::optional<std::string>>> {
+    return session->recv_many(max)
+        .then(std::bind(&on_recv_many, ph::_1));
+}
+
+auto receiver::on_chunk(std::function<void(std::string)> fn) -> subscriber<std::string> {
+    auto session = this->session;
+    return subscriber<std::string>([session](executor_t executor, stream_handlers<std::string> handlers) {
+        auto subscription = std::make_shared<subscription_t>(subscription_t {
+            std::move(handlers), session
+        });
+
+        session->subscribe(std::move(executor), [subscription](decoded_message&& message) {
+            on_stream_chunk(*subscription, message);
+        }, [subscription](const std::error_code& ec) {
+            on_stream_error(*subscription, std::make_exception_ptr(std::system_error(ec)));
+        });
+    }, std::move(fn));
+}
+
 }  // namespace worker
 }  // namespace framework
 }  // namespace cocaine
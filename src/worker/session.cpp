@@ -16,6 +16,8 @@
 
 #include "cocaine/framework/detail/worker/session.hpp"
 
+#include <asio/write.hpp>
+
 #include <cocaine/hpack/static_table.hpp>
 #include <cocaine/traits/enum.hpp>
 #include <cocaine/idl/streaming.hpp>
@@ -40,47 +42,12 @@ const std::uint64_t CONTROL_CHANNEL_ID = 1;
 const boost::posix_time::time_duration HEARTBEAT_TIMEOUT = boost::posix_time::seconds(10);
 const boost::posix_time::time_duration DISOWN_TIMEOUT = boost::posix_time::seconds(60);
 
-//! \note single shot.
-template<class Session>
-class worker_session_t::push_t : public std::enable_shared_from_this<push_t<Session>> {
-    io::encoder_t::message_type message;
-    std::shared_ptr<Session> session;
-    task<void>::promise_type h;
-
-public:
-    explicit push_t(io::encoder_t::message_type _message, std::shared_ptr<Session> session, task<void>::promise_type&& h) :
-        message(std::move(_message)),
-        session(session),
-        h(std::move(h))
-    {}
-
-    void operator()() {
-        auto transport = session->transport.synchronize();
-        if (*transport) {
-            (*transport)->writer->write(message, std::bind(&push_t::on_write, this->shared_from_this(), ph::_1));
-        } else {
-            h.set_exception(std::system_error(asio::error::not_connected));
-        }
-    }
-
-private:
-    void on_write(const std::error_code& ec) {
-        CF_DBG("write event: %s", CF_EC(ec));
-
-        if (ec) {
-            session->on_error(ec);
-            h.set_exception(std::system_error(ec));
-        } else {
-            h.set_value();
-        }
-    }
-};
-
 worker_session_t::worker_session_t(dispatch_t& dispatch, scheduler_t& scheduler, executor_t executor) :
     dispatch(dispatch),
     scheduler(scheduler),
     executor(std::move(executor)),
     message(boost::none),
+    writing(false),
     counter(0),
     heartbeat_timer(scheduler.loop().loop),
     disown_timer(scheduler.loop().loop)
@@ -107,18 +74,105 @@ worker_session_t::push(io::encoder_t::message_type&& message) {
     promise<void> pr;
     auto fr = pr.get_future();
 
-    scheduler(
-        std::bind(
-            &push_t<worker_session_t>::operator(),
-            std::make_shared<push_t<worker_session_t>>(
-                std::move(message), shared_from_this(), std::move(pr)
-            )
-        )
-    );
+    auto push = std::make_shared<detail::push_t>(detail::push_t{
+        detail::buffer_t(),
+        std::unique_ptr<io::encoder_t::message_type>(new io::encoder_t::message_type(std::move(message))),
+        std::move(pr)
+    });
+
+    scheduler.loop().loop.post(std::bind(&worker_session_t::enqueue, shared_from_this(), std::move(push)));
+
+    return fr;
+}
+
+future<void>
+worker_session_t::push(std::uint64_t span, encode_ref_t encode) {
+    auto buffer = buffers.acquire();
+
+    try {
+        encode(buffer, span);
+    } catch (...) {
+        buffers.release(std::move(buffer));
+        throw;
+    }
+
+    promise<void> pr;
+    auto fr = pr.get_future();
+
+    auto push = std::make_shared<detail::push_t>(detail::push_t{std::move(buffer), nullptr, std::move(pr)});
+
+    scheduler.loop().loop.post(std::bind(&worker_session_t::enqueue, shared_from_this(), std::move(push)));
 
     return fr;
 }
 
+void
+worker_session_t::enqueue(std::shared_ptr<detail::push_t> push) {
+    outbox.push_back(std::move(*push));
+
+    if (!writing) {
+        flush();
+    }
+}
+
+void
+worker_session_t::flush() {
+    if (outbox.empty()) {
+        writing = false;
+        return;
+    }
+
+    auto batch = std::make_shared<std::vector<detail::push_t>>();
+    batch->swap(outbox);
+
+    auto transport = this->transport.synchronize();
+    if (!*transport) {
+        for (auto& push : *batch) {
+            push.pr.set_exception(std::system_error(asio::error::not_connected));
+            buffers.release(std::move(push.buffer));
+        }
+
+        writing = false;
+        return;
+    }
+
+    std::vector<asio::const_buffer> sequence;
+    sequence.reserve(batch->size());
+    for (const auto& push : *batch) {
+        push.gather(sequence);
+    }
+
+    CF_DBG("writing %llu messages ...", CF_US(batch->size()));
+
+    writing = true;
+    asio::async_write(*(*transport)->socket, sequence,
+        std::bind(&worker_session_t::on_write, shared_from_this(), ph::_1, std::move(batch))
+    );
+}
+
+void
+worker_session_t::on_write(const std::error_code& ec, std::shared_ptr<std::vector<detail::push_t>> batch) {
+    CF_DBG("write event: %s", CF_EC(ec));
+
+    for (auto& push : *batch) {
+        if (ec) {
+            push.pr.set_exception(std::system_error(ec));
+        } else {
+            push.pr.set_value();
+        }
+
+        buffers.release(std::move(push.buffer));
+    }
+
+    if (ec) {
+        writing = false;
+        on_error(ec);
+        return;
+    }
+
+    flush();
+}
+
 void
 worker_session_t::revoke(std::uint64_t span) {
     CF_DBG("revoking span %llu channel", CF_US(span));
@@ -128,6 +182,11 @@ worker_session_t::revoke(std::uint64_t span) {
     });
 }
 
+auto
+worker_session_t::timers() -> detail::timer_wheel_t& {
+    return scheduler.loop().timers;
+}
+
 void worker_session_t::handshake(const std::string& uuid) {
     CF_DBG("<- Handshake");
 
@@ -315,9 +374,9 @@ void worker_session_t::process_invoke(std::map<std::uint64_t, std::shared_ptr<sh
             !trace_id->value().empty() && !span_id->value().empty() && ! parent_id->value().empty()) {
         try {
             trace = trace_t(
-                    hpack::header::unpack<uint64_t>(message.get_header<hpack::headers::trace_id<>>()->value()),
-                    hpack::header::unpack<uint64_t>(message.get_header<hpack::headers::span_id<>>()->value()),
-                    hpack::header::unpack<uint64_t>(message.get_header<hpack::headers::parent_id<>>()->value()),
+                    hpack::header::unpack<uint64_t>(trace_id->value()),
+                    hpack::header::unpack<uint64_t>(span_id->value()),
+                    hpack::header::unpack<uint64_t>(parent_id->value()),
                     event);
         } catch (const std::exception& e) {
             CF_DBG("could not decode tracing headers - %s", e.what());
@@ -0,0 +1,81 @@
+/*
+    Copyright (c) 2015 Evgeny Safronov <division494@gmail.com>
+    Copyright (c) 2011-2015 Other contributors as noted in the AUTHORS file.
+    This file is part of Cocaine.
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/framework/detail/zone.hpp"
+
+#include <vector>
+
+#include <cocaine/locked_ptr.hpp>
+
+using namespace cocaine::framework::detail;
+
+namespace {
+
+/// The maximum number of free zones kept for reuse.
+const std::size_t POOL_CAPACITY = 1024;
+
+typedef cocaine::synchronized<std::vector<std::unique_ptr<msgpack::zone>>> pool_type;
+
+/// Returns the process-wide pool of free zones.
+///
+/// \note the pool is intentionally leaked, because zones may be released from static destructors.
+pool_type&
+pool() {
+    static pool_type* pool = new pool_type;
+    return *pool;
+}
+
+} // namespace
+
+auto
+cocaine::framework::detail::acquire_zone() -> std::unique_ptr<msgpack::zone> {
+    auto zone = pool().apply([](std::vector<std::unique_ptr<msgpack::zone>>& zones) -> std::unique_ptr<msgpack::zone> {
+        std::unique_ptr<msgpack::zone> zone;
+        if (!zones.empty()) {
+            zone = std::move(zones.back());
+            zones.pop_back();
+        }
+
+        return zone;
+    });
+
+    if (!zone) {
+        zone.reset(new msgpack::zone);
+    }
+
+    return zone;
+}
+
+void
+cocaine::framework::detail::release_zone(std::unique_ptr<msgpack::zone> zone) noexcept {
+    if (!zone) {
+        return;
+    }
+
+    zone->clear();
+
+    pool().apply([&](std::vector<std::unique_ptr<msgpack::zone>>& zones) {
+        if (zones.size() >= POOL_CAPACITY) {
+            return;
+        }
+
+        try {
+            zones.push_back(std::move(zone));
+        } catch (const std::bad_alloc&) {
+            // The zone is destroyed below.
+        }
+    });
+}
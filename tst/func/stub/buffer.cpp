@@ -0,0 +1,103 @@
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/common.hpp>
+#include <cocaine/idl/streaming.hpp>
+
+#include <cocaine/framework/encoder.hpp>
+
+#include <cocaine/framework/detail/buffer.hpp>
+
+using namespace cocaine;
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+using namespace testing;
+
+namespace {
+
+typedef io::protocol<io::streaming_tag<std::string>>::scope protocol;
+
+auto
+join(const buffer_t& buffer) -> std::string {
+    std::vector<asio::const_buffer> sequence;
+    buffer.gather(sequence);
+
+    std::string result;
+    for (const auto& item : sequence) {
+        result.append(asio::buffer_cast<const char*>(item), asio::buffer_size(item));
+    }
+
+    return result;
+}
+
+} // namespace
+
+TEST(Buffer, CopiesSmallPayload) {
+    const auto payload = std::make_shared<const std::string>(buffer_t::share_threshold - 1, 'x');
+
+    buffer_t buffer;
+    buffer.share(payload);
+    encode<protocol::chunk>(buffer, 42, *payload);
+
+    std::vector<asio::const_buffer> sequence;
+    buffer.gather(sequence);
+
+    EXPECT_EQ(1, sequence.size());
+    EXPECT_LE(payload->size(), buffer.capacity());
+}
+
+TEST(Buffer, ReferencesSharedLargePayload) {
+    const auto payload = std::make_shared<const std::string>(4 * buffer_t::share_threshold, 'x');
+
+    const std::tuple<const std::string&> refs(*payload);
+    buffer_t buffer;
+    encode_ref_t::make<protocol::chunk>(refs).share(payload)(buffer, 42);
+
+    std::vector<asio::const_buffer> sequence;
+    buffer.gather(sequence);
+
+    ASSERT_EQ(2, sequence.size());
+    EXPECT_EQ(payload->data(), asio::buffer_cast<const char*>(sequence[1]));
+    EXPECT_EQ(payload->size(), asio::buffer_size(sequence[1]));
+    EXPECT_GT(buffer_t::share_threshold, buffer.capacity());
+
+    // The gathered content must be the same as if the payload were copied.
+    buffer_t expected;
+    encode<protocol::chunk>(expected, 42, *payload);
+    EXPECT_EQ(expected.size(), buffer.size());
+    EXPECT_EQ(join(expected), join(buffer));
+}
+
+TEST(Buffer, CopiesLargePayloadUnlessShared) {
+    const std::string payload(4 * buffer_t::share_threshold, 'x');
+
+    buffer_t buffer;
+    encode<protocol::chunk>(buffer, 42, payload);
+
+    std::vector<asio::const_buffer> sequence;
+    buffer.gather(sequence);
+
+    EXPECT_EQ(1, sequence.size());
+    EXPECT_LE(payload.size(), buffer.capacity());
+}
+
+TEST(Buffer, KeepsSharedPayloadUntilCleared) {
+    auto payload = std::make_shared<const std::string>(2 * buffer_t::share_threshold, 'x');
+    std::weak_ptr<const std::string> weak(payload);
+
+    buffer_t buffer;
+    buffer.share(payload);
+    encode<protocol::chunk>(buffer, 42, *payload);
+
+    payload.reset();
+    EXPECT_FALSE(weak.expired());
+
+    buffer.clear();
+    EXPECT_TRUE(weak.expired());
+    EXPECT_EQ(0, buffer.size());
+}
@@ -0,0 +1,112 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/framework/cancellation.hpp>
+#include <cocaine/framework/forwards.hpp>
+
+using namespace cocaine;
+using namespace cocaine::framework;
+
+using namespace testing;
+
+TEST(CancellationToken, CallsSubscribersOnce) {
+    cancellation_token_t token;
+
+    int calls = 0;
+    token.subscribe([&] { ++calls; });
+
+    EXPECT_FALSE(token.cancelled());
+
+    token.cancel();
+    token.cancel();
+
+    EXPECT_TRUE(token.cancelled());
+    EXPECT_EQ(1, calls);
+}
+
+TEST(CancellationToken, SharesStateBetweenCopies) {
+    cancellation_token_t token;
+    cancellation_token_t copy(token);
+
+    int calls = 0;
+    token.subscribe([&] { ++calls; });
+
+    copy.cancel();
+
+    EXPECT_TRUE(token.cancelled());
+    EXPECT_EQ(1, calls);
+}
+
+TEST(CancellationToken, SkipsUnsubscribed) {
+    cancellation_token_t token;
+
+    int calls = 0;
+    const auto id = token.subscribe([&] { ++calls; });
+    token.unsubscribe(id);
+    token.cancel();
+
+    EXPECT_EQ(0, calls);
+}
+
+TEST(CancellationToken, CallsLateSubscriberImmediately) {
+    cancellation_token_t token;
+    token.cancel();
+
+    int calls = 0;
+    token.subscribe([&] { ++calls; });
+
+    EXPECT_EQ(1, calls);
+}
+
+TEST(CancellationToken, CancelsWhenAnyLosers) {
+    std::vector<cancellation_token_t> tokens(3);
+
+    std::vector<promise<int>> promises(3);
+    std::vector<framework::future<int>> futures;
+    for (auto& promise : promises) {
+        futures.emplace_back(promise.get_future());
+    }
+
+    // Stands for the channels bound to the tokens.
+    int cancelled = 0;
+    for (auto& token : tokens) {
+        token.subscribe([&] { ++cancelled; });
+    }
+
+    auto result = when_any(futures, tokens);
+    EXPECT_FALSE(tokens[0].cancelled());
+
+    promises[1].set_value(42);
+
+    EXPECT_TRUE(tokens[0].cancelled());
+    EXPECT_FALSE(tokens[1].cancelled());
+    EXPECT_TRUE(tokens[2].cancelled());
+    EXPECT_EQ(2, cancelled);
+    EXPECT_EQ(42, result.get()[1].get());
+}
+
+TEST(CancellationToken, KeepsWhenNWinners) {
+    std::vector<cancellation_token_t> tokens(3);
+
+    std::vector<promise<int>> promises(3);
+    std::vector<framework::future<int>> futures;
+    for (auto& promise : promises) {
+        futures.emplace_back(promise.get_future());
+    }
+
+    // The first operation is ready before the quorum is even awaited.
+    promises[0].set_value(1);
+
+    auto result = when_n(futures, 2, tokens);
+
+    promises[2].set_value(3);
+
+    EXPECT_FALSE(tokens[0].cancelled());
+    EXPECT_TRUE(tokens[1].cancelled());
+    EXPECT_FALSE(tokens[2].cancelled());
+
+    auto ready = result.get();
+    EXPECT_EQ(1, ready[0].get());
+    EXPECT_EQ(3, ready[2].get());
+}
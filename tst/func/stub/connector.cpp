@@ -0,0 +1,99 @@
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <asio/ip/tcp.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/framework/forwards.hpp>
+
+#include <cocaine/framework/detail/connector.hpp>
+#include <cocaine/framework/detail/loop.hpp>
+
+#include "../../util/net.hpp"
+
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+using namespace testing;
+using namespace testing::util;
+
+namespace {
+
+typedef connector_t::endpoint_type endpoint_type;
+
+struct result_t {
+    std::error_code ec;
+    std::unique_ptr<connector_t::socket_type> socket;
+};
+
+auto
+race(loop_t& loop, std::vector<endpoint_type> endpoints, std::chrono::milliseconds delay) -> result_t {
+    auto result = std::make_shared<promise<std::error_code>>();
+    auto socket = std::make_shared<std::unique_ptr<connector_t::socket_type>>();
+
+    auto connector = std::make_shared<connector_t>(loop, std::move(endpoints), delay);
+    connector->connect([=](const std::error_code& ec, std::unique_ptr<connector_t::socket_type> connected) {
+        *socket = std::move(connected);
+        result->set_value(ec);
+    });
+
+    const auto ec = result->get_future().get();
+    return result_t { ec, std::move(*socket) };
+}
+
+/// Returns a loopback endpoint nobody listens on, so connecting to it is refused immediately.
+auto
+refused() -> endpoint_type {
+    return endpoint_type(asio::ip::address_v4::loopback(), port());
+}
+
+} // namespace
+
+TEST(Connector, ConnectsToReachableEndpoint) {
+    client_t client;
+
+    asio::ip::tcp::acceptor acceptor(client.loop(), endpoint_type(asio::ip::address_v4::loopback(), 0));
+
+    auto result = race(client.loop(), { refused(), refused(), acceptor.local_endpoint() }, std::chrono::seconds(10));
+
+    EXPECT_EQ(std::error_code(), result.ec);
+    ASSERT_TRUE(!!result.socket);
+    EXPECT_EQ(acceptor.local_endpoint(), result.socket->remote_endpoint());
+}
+
+TEST(Connector, SkipsBlackholedEndpointAfterDelay) {
+    client_t client;
+
+    asio::ip::tcp::acceptor acceptor(client.loop(), endpoint_type(asio::ip::address_v4::loopback(), 0));
+
+    // Non-routable address, connecting to which either hangs or fails depending on the network.
+    const endpoint_type blackhole(asio::ip::address_v4::from_string("10.255.255.1"), 10053);
+
+    const auto start = std::chrono::steady_clock::now();
+    auto result = race(client.loop(), { blackhole, acceptor.local_endpoint() }, std::chrono::milliseconds(50));
+
+    EXPECT_EQ(std::error_code(), result.ec);
+    ASSERT_TRUE(!!result.socket);
+    EXPECT_EQ(acceptor.local_endpoint(), result.socket->remote_endpoint());
+    EXPECT_GT(std::chrono::seconds(1), std::chrono::steady_clock::now() - start);
+}
+
+TEST(Connector, FailsWithLastErrorWhenAllAttemptsFail) {
+    client_t client;
+
+    auto result = race(client.loop(), { refused(), refused() }, std::chrono::milliseconds(50));
+
+    EXPECT_EQ(asio::error::connection_refused, result.ec);
+    EXPECT_FALSE(!!result.socket);
+}
+
+TEST(Connector, FailsWithoutEndpoints) {
+    client_t client;
+
+    auto result = race(client.loop(), {}, std::chrono::milliseconds(50));
+
+    EXPECT_EQ(asio::error::not_found, result.ec);
+    EXPECT_FALSE(!!result.socket);
+}
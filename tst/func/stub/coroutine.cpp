@@ -0,0 +1,114 @@
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/framework/coroutine.hpp>
+#include <cocaine/framework/scheduler.hpp>
+#include <cocaine/framework/worker/coroutine.hpp>
+
+#include <cocaine/framework/detail/loop.hpp>
+
+#include "../../util/net.hpp"
+
+using namespace cocaine;
+using namespace cocaine::framework;
+
+using namespace testing;
+using namespace testing::util;
+
+namespace {
+
+auto
+increment(future<int>&& fr) -> future<int> {
+    const int value = co_await std::move(fr);
+    co_return value + 1;
+}
+
+auto
+increment_on(scheduler_t& scheduler, future<int>&& fr, std::thread::id& thread) -> future<int> {
+    const int value = co_await resume_on(scheduler, std::move(fr));
+    thread = std::this_thread::get_id();
+    co_return value + 1;
+}
+
+} // namespace
+
+TEST(Coroutine, AwaitsReadyFuture) {
+    auto fr = increment(make_ready_future<int>::value(41));
+
+    EXPECT_TRUE(fr.ready());
+    EXPECT_EQ(42, fr.get());
+}
+
+TEST(Coroutine, AwaitsPendingFuture) {
+    promise<int> pr;
+    auto fr = increment(pr.get_future());
+
+    EXPECT_FALSE(fr.ready());
+
+    pr.set_value(41);
+
+    EXPECT_TRUE(fr.ready());
+    EXPECT_EQ(42, fr.get());
+}
+
+TEST(Coroutine, PropagatesErrors) {
+    promise<int> pr;
+    auto fr = increment(pr.get_future());
+
+    pr.set_exception(std::make_exception_ptr(std::runtime_error("failed")));
+
+    EXPECT_THROW(fr.get(), std::runtime_error);
+}
+
+TEST(Coroutine, ResumesOnScheduler) {
+    client_t client;
+    event_loop_t loop(client.loop());
+    scheduler_t scheduler(loop);
+
+    std::thread::id thread;
+    promise<int> pr;
+    auto fr = increment_on(scheduler, pr.get_future(), thread);
+
+    pr.set_value(41);
+
+    EXPECT_EQ(42, fr.get());
+    EXPECT_NE(std::this_thread::get_id(), thread);
+}
+
+TEST(Coroutine, RunsAsWorkerHandler) {
+    promise<void> pr;
+    auto event = pr.get_future();
+    bool done = false;
+
+    auto handler = worker::transform_traits<dispatch_t, worker::coroutine>::apply(
+        [&](worker::sender, worker::receiver) -> future<void> {
+            co_await std::move(event);
+            done = true;
+        }
+    );
+
+    // The handler returns at the first suspension, leaving the coroutine running.
+    handler(worker::sender(nullptr), worker::receiver(std::vector<hpack::header_t>(), nullptr));
+    EXPECT_FALSE(done);
+
+    pr.set_value();
+    EXPECT_TRUE(done);
+}
+
+TEST(Coroutine, RethrowsWorkerHandlerErrorsBeforeSuspension) {
+    auto handler = worker::transform_traits<dispatch_t, worker::coroutine>::apply(
+        [](worker::sender, worker::receiver) -> future<void> {
+            throw std::runtime_error("failed");
+            co_return;
+        }
+    );
+
+    EXPECT_THROW(
+        handler(worker::sender(nullptr), worker::receiver(std::vector<hpack::header_t>(), nullptr)),
+        std::runtime_error
+    );
+}
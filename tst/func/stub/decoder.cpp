@@ -0,0 +1,219 @@
+#include <cstring>
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/common.hpp>
+#include <cocaine/errors.hpp>
+#include <cocaine/idl/locator.hpp>
+#include <cocaine/rpc/asio/encoder.hpp>
+
+#include <cocaine/framework/message.hpp>
+
+#include <cocaine/framework/detail/decoder.hpp>
+#include <cocaine/framework/detail/slab.hpp>
+
+#include "../../util/alloc.hpp"
+
+using namespace cocaine;
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+using namespace testing;
+
+TEST(Decoder, DecodesFrameFedBytewise) {
+    const auto frame = io::encoded<io::locator::resolve>(42, std::string(1024, 'x'));
+
+    auto slab = slab_t::acquire(frame.size());
+    std::memcpy(slab->data(), frame.data(), frame.size());
+
+    decoder_t decoder;
+    decoded_message message(boost::none);
+
+    for (std::size_t size = 0; size < frame.size(); ++size) {
+        std::error_code ec;
+        EXPECT_EQ(0, decoder.decode(slab, slab->data(), size, message, ec));
+        EXPECT_EQ(cocaine::error::insufficient_bytes, ec);
+        EXPECT_LE(1, decoder.remaining());
+    }
+
+    std::error_code ec;
+    EXPECT_EQ(frame.size(), decoder.decode(slab, slab->data(), frame.size(), message, ec));
+    EXPECT_EQ(std::error_code(), ec);
+    EXPECT_EQ(42, message.span());
+    EXPECT_EQ(std::string(1024, 'x'), message.args().via.array.ptr[0].as<std::string>());
+}
+
+TEST(Decoder, ReportsMissingPayload) {
+    const auto frame = io::encoded<io::locator::resolve>(1, std::string(1024 * 1024, 'x'));
+
+    auto slab = slab_t::acquire(frame.size());
+    std::memcpy(slab->data(), frame.data(), frame.size());
+
+    decoder_t decoder;
+    decoded_message message(boost::none);
+
+    // Once the string header is received, the decoder knows that at least the rest of the string
+    // is required.
+    std::error_code ec;
+    decoder.decode(slab, slab->data(), 64, message, ec);
+    EXPECT_EQ(cocaine::error::insufficient_bytes, ec);
+    EXPECT_LE(1024 * 1024 - 64, decoder.remaining());
+    EXPECT_GE(frame.size() - 64, decoder.remaining());
+}
+
+TEST(Decoder, RejectsReservedType) {
+    auto slab = slab_t::acquire();
+    slab->data()[0] = static_cast<char>(0xc1);
+
+    decoder_t decoder;
+    decoded_message message(boost::none);
+
+    std::error_code ec;
+    decoder.decode(slab, slab->data(), 1, message, ec);
+    EXPECT_EQ(cocaine::error::parse_error, ec);
+}
+
+TEST(Decoder, RejectsOversizedFrame) {
+    // [1, 0, ["<4 GiB string>"]], of which only the string header is received.
+    const unsigned char frame[] = { 0x93, 0x01, 0x00, 0x91, 0xdb, 0xff, 0xff, 0xff, 0xff };
+
+    auto slab = slab_t::acquire();
+    std::memcpy(slab->data(), frame, sizeof(frame));
+
+    decoder_t decoder;
+    decoded_message message(boost::none);
+
+    std::error_code ec;
+    EXPECT_EQ(0, decoder.decode(slab, slab->data(), sizeof(frame), message, ec));
+    EXPECT_EQ(cocaine::error::frame_format_error, ec);
+}
+
+TEST(Decoder, RejectsOversizedContainer) {
+    // [1, 0, <array of 4G elements>], of which only the array header is received.
+    const unsigned char frame[] = { 0x93, 0x01, 0x00, 0xdd, 0xff, 0xff, 0xff, 0xff };
+
+    auto slab = slab_t::acquire();
+    std::memcpy(slab->data(), frame, sizeof(frame));
+
+    decoder_t decoder;
+    decoded_message message(boost::none);
+
+    std::error_code ec;
+    EXPECT_EQ(0, decoder.decode(slab, slab->data(), sizeof(frame), message, ec));
+    EXPECT_EQ(cocaine::error::frame_format_error, ec);
+}
+
+TEST(Decoder, DecodesLiteralHeadersOnAccess) {
+    msgpack::sbuffer buffer;
+    msgpack::packer<msgpack::sbuffer> packer(buffer);
+
+    packer.pack_array(4);
+    packer.pack(7);
+    packer.pack(0);
+    packer.pack_array(1);
+    packer.pack(std::string("node"));
+    packer.pack_array(2);
+    for (const auto& name : { std::string("first"), std::string("second") }) {
+        packer.pack_array(3);
+        packer.pack(false);
+        packer.pack(name);
+        packer.pack(std::string("value"));
+    }
+
+    auto slab = slab_t::acquire();
+    std::memcpy(slab->data(), buffer.data(), buffer.size());
+
+    decoder_t decoder;
+    decoded_message message(boost::none);
+
+    std::error_code ec;
+    EXPECT_EQ(buffer.size(), decoder.decode(slab, slab->data(), buffer.size(), message, ec));
+    EXPECT_EQ(std::error_code(), ec);
+    EXPECT_EQ(7, message.span());
+
+    EXPECT_EQ(2, message.meta().size());
+    EXPECT_FALSE(message.get_header<hpack::headers::trace_id<>>());
+}
+
+TEST(Decoder, RejectsMalformedHeaders) {
+    msgpack::sbuffer buffer;
+    msgpack::packer<msgpack::sbuffer> packer(buffer);
+
+    packer.pack_array(4);
+    packer.pack(7);
+    packer.pack(0);
+    packer.pack_array(0);
+    packer.pack_array(1);
+    packer.pack(std::string("junk"));
+
+    auto slab = slab_t::acquire();
+    std::memcpy(slab->data(), buffer.data(), buffer.size());
+
+    decoder_t decoder;
+    decoded_message message(boost::none);
+
+    std::error_code ec;
+    decoder.decode(slab, slab->data(), buffer.size(), message, ec);
+    EXPECT_EQ(cocaine::error::frame_format_error, ec);
+}
+
+TEST(DecodedMessage, ThrowsOnMalformedPostponedHeaders) {
+    msgpack::sbuffer buffer;
+    msgpack::packer<msgpack::sbuffer> packer(buffer);
+
+    packer.pack_array(4);
+    packer.pack(7);
+    packer.pack(0);
+    packer.pack_array(0);
+    packer.pack_array(2);
+    packer.pack_array(3);
+    packer.pack(false);
+    packer.pack(std::string("name"));
+    packer.pack(std::string("value"));
+    packer.pack(std::string("junk"));
+
+    std::unique_ptr<msgpack::zone> zone(new msgpack::zone);
+
+    msgpack::object object;
+    std::size_t offset = 0;
+    ASSERT_EQ(msgpack::UNPACK_SUCCESS, msgpack::unpack(buffer.data(), buffer.size(), &offset, zone.get(), &object));
+
+    decoded_message message(object, std::move(zone), slab_t::acquire());
+
+    EXPECT_THROW(message.meta(), std::system_error);
+    EXPECT_TRUE(message.meta().empty());
+}
+
+TEST(Decoder, ReusesResourcesForSmallMessages) {
+    const auto frame = io::encoded<io::locator::resolve>(1, std::string("node"));
+
+    const std::size_t count = 1000;
+
+    auto slab = slab_t::acquire();
+    for (std::size_t id = 0; id < count; ++id) {
+        std::memcpy(slab->data() + id * frame.size(), frame.data(), frame.size());
+    }
+
+    decoder_t decoder;
+
+    auto decode = [&](std::size_t id) {
+        decoded_message message(boost::none);
+        std::error_code ec;
+        decoder.decode(slab, slab->data() + id * frame.size(), frame.size(), message, ec);
+        EXPECT_EQ(std::error_code(), ec);
+    };
+
+    // Warm up pools.
+    decode(0);
+
+    const auto before = util::allocations();
+    for (std::size_t id = 1; id < count; ++id) {
+        decode(id);
+    }
+
+    // Zones and slabs are reused and messages have no heap parts, so nothing is allocated.
+    EXPECT_EQ(0, util::allocations() - before);
+}
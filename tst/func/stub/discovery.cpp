@@ -0,0 +1,126 @@
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <asio/ip/tcp.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/common.hpp>
+#include <cocaine/idl/locator.hpp>
+#include <cocaine/traits/endpoint.hpp>
+#include <cocaine/traits/graph.hpp>
+#include <cocaine/traits/map.hpp>
+#include <cocaine/traits/tuple.hpp>
+#include <cocaine/traits/vector.hpp>
+
+#include <cocaine/framework/message.hpp>
+#include <cocaine/framework/scheduler.hpp>
+
+#include <cocaine/framework/detail/discovery.hpp>
+#include <cocaine/framework/detail/loop.hpp>
+
+#include "../../util/net.hpp"
+#include "../../util/stub.hpp"
+
+using namespace cocaine;
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+using namespace testing;
+using namespace testing::util;
+
+namespace {
+
+typedef std::tuple<std::vector<asio::ip::tcp::endpoint>, unsigned int, io::graph_root_t> resolve_result;
+typedef io::protocol<io::event_traits<io::locator::connect>::upstream_type>::scope protocol;
+
+class watcher_mock_t : public watcher_t {
+    std::string service;
+
+public:
+    std::vector<resolver_t::result_t> updates;
+    promise<resolver_t::result_t> updated;
+
+    explicit
+    watcher_mock_t(std::string service) :
+        service(std::move(service))
+    {}
+
+    auto
+    name() const -> const std::string& {
+        return service;
+    }
+
+    void
+    update(const resolver_t::result_t& result) {
+        if (updates.empty()) {
+            updated.set_value(result);
+        }
+
+        updates.push_back(result);
+    }
+};
+
+} // namespace
+
+TEST(Discovery, PassesUpdatesToWatchersOfService) {
+    client_t client;
+    event_loop_t loop(client.loop());
+    scheduler_t scheduler(loop);
+
+    auto discovery = std::make_shared<discovery_t>(scheduler, std::vector<resolver_t::endpoint_type>());
+
+    auto echo = std::make_shared<watcher_mock_t>("echo");
+    auto storage = std::make_shared<watcher_mock_t>("storage");
+    auto gone = std::make_shared<watcher_mock_t>("echo");
+
+    discovery->attach(echo);
+    discovery->attach(storage);
+    discovery->attach(gone);
+    gone.reset();
+
+    const resolver_t::result_t result = {
+        { resolver_t::endpoint_type(boost::asio::ip::address_v4::loopback(), 42) }, 1
+    };
+
+    discovery->update("echo", result);
+
+    ASSERT_EQ(1, echo->updates.size());
+    EXPECT_EQ(result.endpoints, echo->updates[0].endpoints);
+    EXPECT_EQ(1, echo->updates[0].version);
+    EXPECT_TRUE(storage->updates.empty());
+}
+
+TEST(Discovery, SubscribesToStubLocator) {
+    const asio::ip::tcp::endpoint service(asio::ip::address_v4::loopback(), 42);
+
+    // The stub locator announces the echo service right after the subscription is requested.
+    stub_t locator([&](const std::shared_ptr<stub_t::connection_t>& connection, const decoded_message& message) {
+        std::map<std::string, resolve_result> services;
+        services["echo"] = resolve_result(std::vector<asio::ip::tcp::endpoint>{ service }, 1, io::graph_root_t());
+
+        connection->send<protocol::chunk>(message.span(), std::string("locator"), services);
+    });
+
+    client_t client;
+    event_loop_t loop(client.loop());
+    scheduler_t scheduler(loop);
+
+    auto discovery = std::make_shared<discovery_t>(scheduler, std::vector<resolver_t::endpoint_type> {
+        locator.endpoint()
+    });
+
+    auto echo = std::make_shared<watcher_mock_t>("echo");
+    discovery->attach(echo);
+    discovery->start();
+
+    const auto result = echo->updated.get_future().get();
+    ASSERT_EQ(1, result.endpoints.size());
+    EXPECT_EQ(42, result.endpoints[0].port());
+    EXPECT_EQ(1, result.version);
+
+    discovery.reset();
+}
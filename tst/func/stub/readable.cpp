@@ -0,0 +1,158 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+
+#include <asio/local/connect_pair.hpp>
+#include <asio/local/stream_protocol.hpp>
+#include <asio/write.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/common.hpp>
+#include <cocaine/idl/locator.hpp>
+#include <cocaine/rpc/asio/encoder.hpp>
+
+#include <cocaine/framework/message.hpp>
+
+#include <cocaine/framework/detail/decoder.hpp>
+#include <cocaine/framework/detail/loop.hpp>
+#include <cocaine/framework/detail/readable.hpp>
+
+using namespace cocaine;
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+using namespace testing;
+
+namespace {
+
+typedef asio::local::stream_protocol protocol_type;
+typedef readable_stream<protocol_type, decoder_t> reader_type;
+
+class pair_t {
+public:
+    loop_t loop;
+    protocol_type::socket tx;
+    std::shared_ptr<protocol_type::socket> rx;
+    std::shared_ptr<reader_type> reader;
+
+    pair_t() :
+        tx(loop),
+        rx(std::make_shared<protocol_type::socket>(loop))
+    {
+        asio::local::connect_pair(tx, *rx);
+        reader = std::make_shared<reader_type>(rx);
+    }
+
+    void
+    send(const io::encoder_t::message_type& message) {
+        asio::write(tx, asio::buffer(message.data(), message.size()));
+    }
+
+    decoded_message
+    recv() {
+        decoded_message message(boost::none);
+        std::error_code result = asio::error::would_block;
+
+        reader->read(message, [&](const std::error_code& ec) {
+            result = ec;
+        });
+
+        loop.reset();
+        while (result == asio::error::would_block && loop.run_one()) {}
+
+        EXPECT_EQ(std::error_code(), result);
+        return message;
+    }
+};
+
+auto
+encode(std::uint64_t span, const std::string& name) -> io::encoder_t::message_type {
+    return io::encoded<io::locator::resolve>(span, name);
+}
+
+auto
+name(const decoded_message& message) -> const msgpack::object_raw& {
+    return message.args().via.array.ptr[0].via.raw;
+}
+
+} // namespace
+
+TEST(ReadableStream, DecodesInPlace) {
+    pair_t pair;
+
+    const std::string node(decoder_t::copy_threshold, 'n');
+    const std::string storage(decoder_t::copy_threshold, 's');
+
+    const auto first = encode(1, node);
+    const auto second = encode(2, storage);
+    pair.send(first);
+    pair.send(second);
+
+    auto m1 = pair.recv();
+    auto m2 = pair.recv();
+
+    EXPECT_EQ(1, m1.span());
+    EXPECT_EQ(2, m2.span());
+    EXPECT_EQ(node, m1.args().via.array.ptr[0].as<std::string>());
+    EXPECT_EQ(storage, m2.args().via.array.ptr[0].as<std::string>());
+
+    // Both messages were received by a single read, so their payloads must lie in the same slab
+    // exactly one frame apart, if they weren't copied.
+    EXPECT_EQ(static_cast<std::ptrdiff_t>(first.size()), name(m2).ptr - name(m1).ptr);
+}
+
+TEST(Decoder, CopiesSmallFrames) {
+    const auto small = encode(1, "node");
+    const auto large = encode(2, std::string(decoder_t::copy_threshold, 'x'));
+
+    auto slab = slab_t::acquire();
+    std::memcpy(slab->data(), small.data(), small.size());
+    std::memcpy(slab->data() + small.size(), large.data(), large.size());
+
+    decoder_t decoder;
+    std::error_code ec;
+
+    decoded_message m1(boost::none);
+    EXPECT_EQ(small.size(), decoder.decode(slab, slab->data(), small.size() + large.size(), m1, ec));
+    EXPECT_EQ(std::error_code(), ec);
+
+    // The small message must not keep the slab alive.
+    EXPECT_TRUE(slab->unique());
+    EXPECT_EQ("node", m1.args().via.array.ptr[0].as<std::string>());
+
+    decoded_message m2(boost::none);
+    const char* data = slab->data() + small.size();
+    EXPECT_EQ(large.size(), decoder.decode(slab, data, large.size(), m2, ec));
+    EXPECT_EQ(std::error_code(), ec);
+
+    EXPECT_FALSE(slab->unique());
+    EXPECT_TRUE(name(m2).ptr >= data && name(m2).ptr < data + large.size());
+}
+
+TEST(ReadableStream, DecodesFramesLargerThanSlab) {
+    pair_t pair;
+
+    const std::string large(3 * slab_t::default_capacity, 'x');
+
+    boost::thread thread([&] {
+        pair.send(encode(1, "node"));
+        pair.send(encode(2, large));
+        pair.send(encode(3, "storage"));
+    });
+
+    auto m1 = pair.recv();
+    auto m2 = pair.recv();
+    auto m3 = pair.recv();
+
+    thread.join();
+
+    EXPECT_EQ(1, m1.span());
+    EXPECT_EQ(2, m2.span());
+    EXPECT_EQ(3, m3.span());
+    EXPECT_EQ("node", m1.args().via.array.ptr[0].as<std::string>());
+    EXPECT_EQ(large, m2.args().via.array.ptr[0].as<std::string>());
+    EXPECT_EQ("storage", m3.args().via.array.ptr[0].as<std::string>());
+}
@@ -0,0 +1,267 @@
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <asio/ip/tcp.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/common.hpp>
+#include <cocaine/idl/locator.hpp>
+#include <cocaine/traits/endpoint.hpp>
+#include <cocaine/traits/graph.hpp>
+#include <cocaine/traits/tuple.hpp>
+#include <cocaine/traits/vector.hpp>
+
+#include <cocaine/framework/message.hpp>
+#include <cocaine/framework/scheduler.hpp>
+#include <cocaine/framework/session.hpp>
+
+#include <cocaine/framework/detail/loop.hpp>
+#include <cocaine/framework/detail/resolver.hpp>
+
+#include "../../util/net.hpp"
+#include "../../util/stub.hpp"
+
+using namespace cocaine;
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+using namespace testing;
+using namespace testing::util;
+
+namespace {
+
+typedef io::protocol<io::event_traits<io::locator::resolve>::upstream_type>::scope protocol;
+
+/// Stub locator, which resolves any service to the same endpoint, answering with the number of
+/// the request as the version, so that fresh results can be told from cached ones.
+class locator_t {
+    /// Requests, which answers are held, accessed from the server thread only.
+    std::vector<std::pair<std::shared_ptr<stub_t::connection_t>, std::uint64_t>> held;
+
+public:
+    std::atomic<unsigned int> requests;
+
+    /// Answers are held until released.
+    std::atomic<bool> holding;
+    /// Connections are closed instead of being answered.
+    std::atomic<bool> dropping;
+
+private:
+    stub_t stub;
+
+public:
+    locator_t() :
+        requests(0),
+        holding(false),
+        dropping(false),
+        stub(std::bind(&locator_t::on_message, this, std::placeholders::_1, std::placeholders::_2))
+    {}
+
+    auto
+    endpoints() const -> std::vector<resolver_t::endpoint_type> {
+        return { stub.endpoint() };
+    }
+
+    auto
+    connections() const -> unsigned int {
+        return stub.connections;
+    }
+
+    /// Answers the held requests.
+    void
+    release() {
+        holding = false;
+
+        stub.post([&] {
+            for (auto& request : held) {
+                answer(request.first, request.second);
+            }
+
+            held.clear();
+        });
+    }
+
+private:
+    void
+    on_message(const std::shared_ptr<stub_t::connection_t>& connection, const decoded_message& message) {
+        ++requests;
+
+        if (dropping) {
+            connection->socket.close();
+            return;
+        }
+
+        if (holding) {
+            held.push_back(std::make_pair(connection, message.span()));
+        } else {
+            answer(connection, message.span());
+        }
+    }
+
+    void
+    answer(const std::shared_ptr<stub_t::connection_t>& connection, std::uint64_t span) {
+        const std::vector<asio::ip::tcp::endpoint> endpoints {
+            asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 42)
+        };
+
+        connection->send<protocol::value>(span, endpoints, requests.load(), io::graph_root_t());
+    }
+};
+
+} // namespace
+
+TEST(SerializedResolver, ServesCachedResultWithinTtl) {
+    locator_t locator;
+
+    client_t client;
+    event_loop_t loop(client.loop());
+    scheduler_t scheduler(loop);
+
+    auto resolver = std::make_shared<serialized_resolver_t>(locator.endpoints(), scheduler);
+
+    EXPECT_EQ(1u, resolver->resolve("echo").get().version);
+
+    auto cached = resolver->resolve("echo");
+    ASSERT_TRUE(cached.ready());
+    EXPECT_EQ(1u, cached.get().version);
+    EXPECT_EQ(1u, locator.requests.load());
+}
+
+TEST(SerializedResolver, ServesStaleResultWhileRefreshing) {
+    locator_t locator;
+
+    client_t client;
+    event_loop_t loop(client.loop());
+    scheduler_t scheduler(loop);
+
+    auto resolver = std::make_shared<serialized_resolver_t>(locator.endpoints(), scheduler);
+    resolver->ttl(std::chrono::milliseconds(50));
+
+    EXPECT_EQ(1u, resolver->resolve("echo").get().version);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    locator.holding = true;
+
+    // The expired result is served right away, while the refresh is held by the locator.
+    auto stale = resolver->resolve("echo");
+    ASSERT_TRUE(stale.ready());
+    EXPECT_EQ(1u, stale.get().version);
+
+    ASSERT_TRUE(eventually([&] { return locator.requests == 2; }));
+
+    auto pending = resolver->resolve("echo");
+    ASSERT_TRUE(pending.ready());
+    EXPECT_EQ(1u, pending.get().version);
+    EXPECT_EQ(2u, locator.requests.load());
+
+    locator.release();
+
+    EXPECT_TRUE(eventually([&] { return resolver->resolve("echo").get().version == 2; }));
+}
+
+TEST(SerializedResolver, KeepsStaleResultWhenRefreshFails) {
+    locator_t locator;
+
+    client_t client;
+    event_loop_t loop(client.loop());
+    scheduler_t scheduler(loop);
+
+    auto resolver = std::make_shared<serialized_resolver_t>(locator.endpoints(), scheduler);
+    resolver->ttl(std::chrono::milliseconds(50));
+
+    EXPECT_EQ(1u, resolver->resolve("echo").get().version);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    locator.dropping = true;
+
+    EXPECT_EQ(1u, resolver->resolve("echo").get().version);
+    ASSERT_TRUE(eventually([&] { return locator.requests == 2; }));
+
+    locator.dropping = false;
+
+    // Another refresh starts only after the failed one is over, and the stale result must be
+    // served meanwhile and afterwards.
+    EXPECT_TRUE(eventually([&] {
+        auto result = resolver->resolve("echo");
+        EXPECT_TRUE(result.ready());
+        return !result.ready() || locator.requests == 3;
+    }));
+}
+
+TEST(SerializedResolver, InvalidateDropsCachedResult) {
+    locator_t locator;
+
+    client_t client;
+    event_loop_t loop(client.loop());
+    scheduler_t scheduler(loop);
+
+    auto resolver = std::make_shared<serialized_resolver_t>(locator.endpoints(), scheduler);
+
+    EXPECT_EQ(1u, resolver->resolve("echo").get().version);
+
+    resolver->invalidate("echo");
+
+    EXPECT_EQ(2u, resolver->resolve("echo").get().version);
+    EXPECT_EQ(2u, locator.requests.load());
+}
+
+TEST(Resolver, SharesLocatorConnection) {
+    locator_t locator;
+
+    client_t client;
+    event_loop_t loop(client.loop());
+    scheduler_t scheduler(loop);
+
+    auto session = std::make_shared<session_t>(scheduler);
+
+    resolver_t r1(scheduler);
+    resolver_t r2(scheduler);
+    r1.endpoints(locator.endpoints());
+    r2.endpoints(locator.endpoints());
+    r1.locator(session);
+    r2.locator(session);
+
+    auto f1 = r1.resolve("echo");
+    auto f2 = r2.resolve("storage");
+
+    EXPECT_NO_THROW(f1.get());
+    EXPECT_NO_THROW(f2.get());
+    EXPECT_NO_THROW(r1.resolve("node").get());
+
+    EXPECT_EQ(1u, locator.connections());
+    EXPECT_EQ(3u, locator.requests.load());
+}
+
+TEST(Resolver, ReconnectsBrokenLocatorSession) {
+    locator_t locator;
+
+    client_t client;
+    event_loop_t loop(client.loop());
+    scheduler_t scheduler(loop);
+
+    resolver_t resolver(scheduler);
+    resolver.endpoints(locator.endpoints());
+
+    EXPECT_NO_THROW(resolver.resolve("echo").get());
+
+    locator.dropping = true;
+    EXPECT_ANY_THROW(resolver.resolve("echo").get());
+    locator.dropping = false;
+
+    // The session may still be reported as connected until the disconnection is noticed.
+    EXPECT_TRUE(eventually([&] {
+        try {
+            resolver.resolve("echo").get();
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }));
+
+    EXPECT_EQ(2u, locator.connections());
+}
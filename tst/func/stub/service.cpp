@@ -0,0 +1,255 @@
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <asio/ip/tcp.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/common.hpp>
+#include <cocaine/idl/locator.hpp>
+#include <cocaine/idl/node.hpp>
+#include <cocaine/idl/streaming.hpp>
+#include <cocaine/traits/endpoint.hpp>
+#include <cocaine/traits/graph.hpp>
+#include <cocaine/traits/map.hpp>
+#include <cocaine/traits/tuple.hpp>
+#include <cocaine/traits/vector.hpp>
+
+#include <cocaine/framework/manager.hpp>
+#include <cocaine/framework/message.hpp>
+#include <cocaine/framework/service.hpp>
+
+#include "../../util/net.hpp"
+#include "../../util/stub.hpp"
+
+using namespace cocaine;
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+using namespace testing;
+using namespace testing::util;
+
+namespace {
+
+typedef std::tuple<std::vector<asio::ip::tcp::endpoint>, unsigned int, io::graph_root_t> resolve_result;
+
+typedef io::protocol<io::event_traits<io::locator::resolve>::upstream_type>::scope resolve_protocol;
+typedef io::protocol<io::event_traits<io::locator::connect>::upstream_type>::scope connect_protocol;
+typedef io::protocol<io::event_traits<io::app::enqueue>::upstream_type>::scope enqueue_protocol;
+
+/// Stub locator, which resolves every service to the given endpoint and announces services moved
+/// through the routing stream on demand.
+class locator_t {
+    std::uint16_t target;
+
+    /// Routing stream subscriptions, accessed from the server thread only.
+    std::vector<std::pair<std::shared_ptr<stub_t::connection_t>, std::uint64_t>> subscriptions;
+
+public:
+    std::atomic<unsigned int> subscribed;
+
+private:
+    stub_t stub;
+
+public:
+    explicit
+    locator_t(std::uint16_t target) :
+        target(target),
+        subscribed(0),
+        stub(std::bind(&locator_t::on_message, this, std::placeholders::_1, std::placeholders::_2))
+    {}
+
+    auto
+    endpoints() const -> std::vector<session_t::endpoint_type> {
+        return { stub.endpoint() };
+    }
+
+    /// Announces that the given service has moved to the given port.
+    void
+    announce(std::string name, std::uint16_t port) {
+        stub.post([=] {
+            target = port;
+
+            std::map<std::string, resolve_result> services;
+            services[name] = resolve_result(endpoints_of(port), 1, io::graph_root_t());
+
+            for (const auto& subscription : subscriptions) {
+                subscription.first->send<connect_protocol::chunk>(subscription.second, std::string("locator"), services);
+            }
+        });
+    }
+
+private:
+    static
+    auto
+    endpoints_of(std::uint16_t port) -> std::vector<asio::ip::tcp::endpoint> {
+        return { asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), port) };
+    }
+
+    void
+    on_message(const std::shared_ptr<stub_t::connection_t>& connection, const decoded_message& message) {
+        if (message.type() == io::event_traits<io::locator::connect>::id) {
+            subscriptions.push_back(std::make_pair(connection, message.span()));
+            ++subscribed;
+        } else {
+            connection->send<resolve_protocol::value>(message.span(), endpoints_of(target), 1u, io::graph_root_t());
+        }
+    }
+};
+
+/// Stub application, which remembers channels opened and answers them on demand.
+class app_t {
+    /// Channels opened, accessed from the server thread only.
+    std::vector<std::pair<std::shared_ptr<stub_t::connection_t>, std::uint64_t>> channels;
+
+public:
+    std::atomic<unsigned int> invocations;
+
+private:
+    stub_t stub;
+
+public:
+    app_t() :
+        invocations(0),
+        stub(std::bind(&app_t::on_message, this, std::placeholders::_1, std::placeholders::_2))
+    {}
+
+    auto
+    port() const -> std::uint16_t {
+        return stub.port;
+    }
+
+    auto
+    endpoint() const -> session_t::endpoint_type {
+        return stub.endpoint();
+    }
+
+    auto
+    connections() const -> unsigned int {
+        return stub.connections;
+    }
+
+    void
+    refuse() {
+        stub.refuse();
+    }
+
+    /// Sends the given chunk through each channel opened so far.
+    void
+    reply(std::string chunk) {
+        stub.post([=] {
+            for (const auto& channel : channels) {
+                channel.first->send<enqueue_protocol::chunk>(channel.second, chunk);
+            }
+        });
+    }
+
+private:
+    void
+    on_message(const std::shared_ptr<stub_t::connection_t>& connection, const decoded_message& message) {
+        if (message.type() == io::event_traits<io::app::enqueue>::id) {
+            channels.push_back(std::make_pair(connection, message.span()));
+            ++invocations;
+        }
+    }
+};
+
+} // namespace
+
+TEST(Service, MovesToAnnouncedEndpointsKeepingChannelsOpened) {
+    app_t old;
+    app_t fresh;
+    locator_t locator(old.port());
+
+    service_manager_t manager(locator.endpoints(), 1);
+    manager.shutdown_policy(service_manager_t::shutdown_policy_t::force);
+
+    auto echo = manager.create<io::app_tag>("echo");
+    manager.watch();
+
+    auto channel = echo.invoke<io::app::enqueue>("ping").get();
+    ASSERT_TRUE(eventually([&] { return old.invocations == 1; }));
+    EXPECT_EQ(old.endpoint(), *echo.endpoint());
+
+    ASSERT_TRUE(eventually([&] { return locator.subscribed == 1; }));
+    locator.announce("echo", fresh.port());
+
+    ASSERT_TRUE(eventually([&] {
+        const auto endpoint = echo.endpoint();
+        return endpoint && *endpoint == fresh.endpoint();
+    }));
+
+    // The channel opened before the move still works through the old connection.
+    old.reply("old");
+    EXPECT_EQ(std::string("old"), *channel.rx.recv().get());
+
+    auto moved = echo.invoke<io::app::enqueue>("ping").get();
+    ASSERT_TRUE(eventually([&] { return fresh.invocations == 1; }));
+    EXPECT_EQ(1u, old.invocations.load());
+    EXPECT_EQ(1u, old.connections());
+    EXPECT_EQ(1u, fresh.connections());
+
+    fresh.reply("fresh");
+    EXPECT_EQ(std::string("fresh"), *moved.rx.recv().get());
+}
+
+TEST(Service, PrefersConnectedSessions) {
+    app_t app;
+    locator_t locator(app.port());
+
+    service_manager_t manager(locator.endpoints(), 1);
+    manager.shutdown_policy(service_manager_t::shutdown_policy_t::force);
+
+    auto echo = manager.create<io::app_tag>("echo");
+
+    auto channel = echo.invoke<io::app::enqueue>("ping").get();
+    app.refuse();
+
+    // The session added can't connect, just like a dropped one, and has no invocations in flight
+    // unlike the connected one.
+    echo.pool(2);
+
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_NO_THROW(echo.invoke<io::app::enqueue>("ping").get());
+    }
+
+    EXPECT_TRUE(eventually([&] { return app.invocations == 11; }));
+    EXPECT_EQ(1u, app.connections());
+}
+
+TEST(Service, ConnectsIfAnySessionConnects) {
+    app_t app;
+    locator_t locator(app.port());
+
+    service_manager_t manager(locator.endpoints(), 1);
+    manager.shutdown_policy(service_manager_t::shutdown_policy_t::force);
+
+    auto echo = manager.create<io::app_tag>("echo");
+    echo.connect().get();
+
+    app.refuse();
+    echo.pool(2);
+
+    EXPECT_NO_THROW(echo.connect().get());
+    EXPECT_EQ(1u, app.connections());
+}
+
+TEST(Service, ThrowsIfNoSessionConnects) {
+    app_t app;
+    locator_t locator(app.port());
+
+    service_manager_t manager(locator.endpoints(), 1);
+    manager.shutdown_policy(service_manager_t::shutdown_policy_t::force);
+
+    auto echo = manager.create<io::app_tag>("echo");
+    echo.pool(2);
+
+    app.refuse();
+
+    EXPECT_THROW(echo.connect().get(), std::system_error);
+}
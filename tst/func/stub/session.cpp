@@ -1,8 +1,69 @@
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <asio/ip/tcp.hpp>
+
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <cocaine/framework/scheduler.hpp>
 #include <cocaine/framework/session.hpp>
 
+#include <cocaine/framework/detail/loop.hpp>
+
 using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
 
 using namespace testing;
+
+TEST(Session, CompletesConcurrentConnects) {
+    loop_t io;
+    std::unique_ptr<loop_t::work> work(new loop_t::work(io));
+
+    event_loop_t loop(io);
+    scheduler_t scheduler(loop);
+
+    // Connection callbacks are run by several threads, so that the waiters of a connection
+    // attempt may be notified while others are still joining it.
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            io.run();
+        });
+    }
+
+    {
+        // Connections are established by the kernel without being accepted.
+        asio::ip::tcp::acceptor acceptor(io, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+        const session_t::endpoint_type endpoint(boost::asio::ip::address_v4::loopback(), acceptor.local_endpoint().port());
+
+        for (int round = 0; round < 100; ++round) {
+            auto session = std::make_shared<session_t>(scheduler);
+
+            std::vector<future<void>> futures;
+            for (int i = 0; i < 8; ++i) {
+                futures.push_back(session->connect(endpoint));
+            }
+
+            for (auto& future : futures) {
+                future.wait_for(std::chrono::seconds(1));
+                EXPECT_TRUE(future.ready());
+
+                if (future.ready()) {
+                    EXPECT_NO_THROW(future.get());
+                }
+            }
+
+            EXPECT_TRUE(session->connected());
+        }
+    }
+
+    work.reset();
+    io.stop();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
@@ -0,0 +1,287 @@
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/common.hpp>
+#include <cocaine/idl/locator.hpp>
+#include <cocaine/rpc/asio/encoder.hpp>
+
+#include <cocaine/framework/message.hpp>
+
+#include <cocaine/framework/detail/decoder.hpp>
+#include <cocaine/framework/detail/loop.hpp>
+#include <cocaine/framework/detail/shared_state.hpp>
+#include <cocaine/framework/detail/slab.hpp>
+
+#include "../../util/alloc.hpp"
+
+using namespace cocaine;
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+using namespace testing;
+
+namespace {
+
+auto
+make(std::uint64_t span) -> decoded_message {
+    const auto frame = io::encoded<io::locator::resolve>(span, std::string("node"));
+
+    auto slab = slab_t::acquire(frame.size());
+    std::memcpy(slab->data(), frame.data(), frame.size());
+
+    decoder_t decoder;
+    decoded_message message(boost::none);
+
+    std::error_code ec;
+    EXPECT_EQ(frame.size(), decoder.decode(slab, slab->data(), frame.size(), message, ec));
+    EXPECT_EQ(std::error_code(), ec);
+    return message;
+}
+
+} // namespace
+
+TEST(SharedState, DeliversBufferedMessagesInOrder) {
+    shared_state_t state;
+
+    // Enough to span several queue blocks.
+    for (std::uint64_t span = 1; span <= 100; ++span) {
+        state.put(make(span));
+    }
+
+    for (std::uint64_t span = 1; span <= 100; ++span) {
+        EXPECT_EQ(span, state.get().get().span());
+    }
+}
+
+TEST(SharedState, CompletesWaitersInOrder) {
+    shared_state_t state;
+
+    auto f1 = state.get();
+    auto f2 = state.get();
+    auto f3 = state.get();
+    EXPECT_FALSE(f1.ready());
+
+    state.put(make(1));
+    state.put(make(2));
+    EXPECT_TRUE(f2.ready());
+    EXPECT_FALSE(f3.ready());
+
+    state.put(make(3));
+    EXPECT_EQ(1, f1.get().span());
+    EXPECT_EQ(2, f2.get().span());
+    EXPECT_EQ(3, f3.get().span());
+}
+
+TEST(SharedState, FailsWaitersWhenCancelled) {
+    shared_state_t state;
+
+    state.put(make(1));
+    auto f1 = state.get();
+    auto f2 = state.get();
+    auto f3 = state.get();
+
+    state.cancel(std::make_error_code(std::errc::operation_canceled));
+    state.put(make(2));
+    state.put(std::make_error_code(std::errc::broken_pipe));
+
+    EXPECT_EQ(1, f1.get().span());
+    EXPECT_THROW(f2.get(), std::system_error);
+    EXPECT_THROW(f3.get(), std::system_error);
+
+    try {
+        state.get().get();
+        FAIL();
+    } catch (const std::system_error& err) {
+        EXPECT_EQ(std::make_error_code(std::errc::operation_canceled), err.code());
+    }
+}
+
+TEST(SharedState, TakesBufferedMessages) {
+    shared_state_t state;
+
+    for (std::uint64_t span = 1; span <= 5; ++span) {
+        state.put(make(span));
+    }
+
+    std::vector<decoded_message> messages;
+    state.take(messages, 3);
+    ASSERT_EQ(3, messages.size());
+    EXPECT_EQ(3, messages.back().span());
+
+    messages.clear();
+    state.take(messages, 10);
+    ASSERT_EQ(2, messages.size());
+    EXPECT_EQ(4, messages.front().span());
+    EXPECT_EQ(5, messages.back().span());
+
+    // Waiters are completed first.
+    auto future = state.get();
+    messages.clear();
+    state.take(messages, 10);
+    EXPECT_TRUE(messages.empty());
+
+    state.put(make(6));
+    EXPECT_EQ(6, future.get().span());
+}
+
+TEST(SharedState, ReceivesContinuouslyWithoutAllocations) {
+    shared_state_t state;
+
+    std::vector<decoded_message> messages;
+    for (std::uint64_t span = 1; span <= 64; ++span) {
+        messages.emplace_back(make(span));
+    }
+
+    // Warm up, so that there is a spare block to be recycled.
+    for (std::uint64_t span = 1; span <= 32; ++span) {
+        state.put(make(span));
+        state.get().get();
+    }
+
+    const auto before = util::allocations();
+    for (auto& message : messages) {
+        state.put(std::move(message));
+        EXPECT_TRUE(state.get().ready());
+    }
+
+    EXPECT_EQ(0, util::allocations() - before);
+}
+
+TEST(SharedState, PassesMessagesBetweenThreads) {
+    const std::uint64_t count = 10000;
+
+    std::vector<decoded_message> messages;
+    for (std::uint64_t span = 1; span <= count; ++span) {
+        messages.emplace_back(make(span));
+    }
+
+    shared_state_t state;
+
+    std::thread producer([&] {
+        for (auto& message : messages) {
+            state.put(std::move(message));
+        }
+    });
+
+    for (std::uint64_t span = 1; span <= count; ++span) {
+        EXPECT_EQ(span, state.get().get().span());
+    }
+
+    producer.join();
+}
+
+TEST(SharedState, PushesMessagesToSubscriber) {
+    shared_state_t state;
+
+    state.put(make(1));
+    state.put(make(2));
+
+    std::vector<std::uint64_t> spans;
+    std::vector<std::error_code> errors;
+
+    state.subscribe(executor_t(), [&](decoded_message&& message) {
+        spans.push_back(message.span());
+    }, [&](const std::error_code& ec) {
+        errors.push_back(ec);
+    });
+
+    EXPECT_EQ((std::vector<std::uint64_t>{1, 2}), spans);
+
+    state.put(make(3));
+    state.cancel(std::make_error_code(std::errc::operation_canceled));
+    state.put(make(4));
+    state.put(std::make_error_code(std::errc::broken_pipe));
+
+    EXPECT_EQ((std::vector<std::uint64_t>{1, 2, 3}), spans);
+    ASSERT_EQ(1, errors.size());
+    EXPECT_EQ(std::make_error_code(std::errc::operation_canceled), errors.front());
+}
+
+TEST(SharedState, PushesMessagesOnExecutor) {
+    std::vector<unique_function<void()>> tasks;
+    executor_t executor = [&](unique_function<void()> task) {
+        tasks.push_back(std::move(task));
+    };
+
+    shared_state_t state;
+
+    std::vector<std::uint64_t> spans;
+    state.subscribe(executor, [&](decoded_message&& message) {
+        spans.push_back(message.span());
+    }, [&](const std::error_code&) {});
+
+    state.put(make(1));
+    state.put(make(2));
+    EXPECT_TRUE(spans.empty());
+
+    // Messages put while a delivery is pending are delivered by it.
+    ASSERT_EQ(1, tasks.size());
+    tasks.front()();
+
+    EXPECT_EQ((std::vector<std::uint64_t>{1, 2}), spans);
+}
+
+TEST(SharedState, PushesMessagesSeriallyOnMultithreadedExecutor) {
+    const std::uint64_t count = 10000;
+
+    std::vector<decoded_message> messages;
+    for (std::uint64_t span = 1; span <= count; ++span) {
+        messages.emplace_back(make(span));
+    }
+
+    loop_t loop;
+    std::unique_ptr<loop_t::work> work(new loop_t::work(loop));
+
+    std::vector<std::thread> threads;
+    for (int id = 0; id < 4; ++id) {
+        threads.emplace_back([&] {
+            loop.run();
+        });
+    }
+
+    executor_t executor = [&](unique_function<void()> task) {
+        loop.post(closure_handler_t(std::move(task)));
+    };
+
+    std::atomic<int> active(0);
+    std::atomic<bool> overlapped(false);
+    std::vector<std::uint64_t> spans;
+    promise<std::error_code> closed;
+
+    shared_state_t state;
+    state.subscribe(executor, [&](decoded_message&& message) {
+        if (active.fetch_add(1) != 0) {
+            overlapped = true;
+        }
+
+        spans.push_back(message.span());
+        active.fetch_sub(1);
+    }, [&](const std::error_code& ec) {
+        closed.set_value(ec);
+    });
+
+    for (auto& message : messages) {
+        state.put(std::move(message));
+    }
+
+    state.put(std::make_error_code(std::errc::broken_pipe));
+
+    EXPECT_EQ(std::make_error_code(std::errc::broken_pipe), closed.get_future().get());
+
+    work.reset();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_FALSE(overlapped);
+    ASSERT_EQ(count, spans.size());
+    for (std::uint64_t span = 1; span <= count; ++span) {
+        EXPECT_EQ(span, spans[span - 1]);
+    }
+}
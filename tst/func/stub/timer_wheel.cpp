@@ -0,0 +1,119 @@
+#include <chrono>
+#include <future>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/framework/detail/loop.hpp>
+#include <cocaine/framework/detail/timer_wheel.hpp>
+
+using namespace cocaine;
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+using namespace testing;
+
+namespace {
+
+typedef timer_wheel_t::clock_type clock_type;
+
+/// Runs the loop until the given number of timers are fired.
+void
+run(loop_t& loop, const std::vector<int>& fired, std::size_t count) {
+    loop.reset();
+    while (fired.size() < count && loop.run_one()) {}
+}
+
+} // namespace
+
+TEST(TimerWheel, ExpiresInDeadlineOrder) {
+    loop_t loop;
+    timer_wheel_t wheel(loop, std::chrono::milliseconds(1));
+
+    std::vector<int> fired;
+    int early = 0;
+
+    const auto now = clock_type::now();
+    for (int id : {3, 1, 2}) {
+        const auto deadline = now + std::chrono::milliseconds(10 * id);
+        wheel.schedule(deadline, [&, id, deadline] {
+            early += clock_type::now() < deadline;
+            fired.push_back(id);
+        });
+    }
+
+    run(loop, fired, 3);
+
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), fired);
+    EXPECT_EQ(0, early);
+    EXPECT_EQ(0, wheel.size());
+}
+
+TEST(TimerWheel, CascadesTimersFromUpperLevels) {
+    loop_t loop;
+    timer_wheel_t wheel(loop, std::chrono::milliseconds(1));
+
+    std::vector<int> fired;
+
+    // Both timers are beyond the first level, which covers 64 ticks.
+    const auto deadline = clock_type::now() + std::chrono::milliseconds(150);
+    wheel.schedule(deadline, [&] {
+        EXPECT_LE(deadline, clock_type::now());
+        fired.push_back(1);
+    });
+    wheel.schedule(deadline + std::chrono::milliseconds(1), [&] {
+        fired.push_back(2);
+    });
+
+    run(loop, fired, 2);
+
+    EXPECT_EQ((std::vector<int>{1, 2}), fired);
+}
+
+TEST(TimerWheel, SkipsCancelledTimers) {
+    loop_t loop;
+    timer_wheel_t wheel(loop, std::chrono::milliseconds(1));
+
+    std::vector<int> fired;
+
+    const auto now = clock_type::now();
+    auto cancelled = wheel.schedule(now + std::chrono::milliseconds(5), [&] {
+        fired.push_back(1);
+    });
+    wheel.schedule(now + std::chrono::milliseconds(10), [&] {
+        fired.push_back(2);
+    });
+
+    EXPECT_TRUE(cancelled->cancel());
+    EXPECT_FALSE(cancelled->cancel());
+
+    run(loop, fired, 1);
+
+    EXPECT_EQ((std::vector<int>{2}), fired);
+    EXPECT_EQ(0, wheel.size());
+}
+
+TEST(TimerWheel, StopsAfterCancellingFarTimers) {
+    loop_t loop;
+    timer_wheel_t wheel(loop, std::chrono::milliseconds(1));
+
+    const auto now = clock_type::now();
+    auto timer = wheel.schedule(now + std::chrono::hours(1), [] {});
+
+    // The far timer is cancelled after the wheel has been ticking for a while.
+    wheel.schedule(now + std::chrono::milliseconds(5), [&] {
+        EXPECT_TRUE(timer->cancel());
+    });
+
+    auto done = std::async(std::launch::async, [&] {
+        loop.run();
+    });
+
+    const bool returned = done.wait_for(std::chrono::seconds(1)) == std::future_status::ready;
+    if (!returned) {
+        loop.stop();
+    }
+
+    EXPECT_TRUE(returned);
+    EXPECT_EQ(0, wheel.size());
+}
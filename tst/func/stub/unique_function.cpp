@@ -0,0 +1,108 @@
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/framework/forwards.hpp>
+
+#include "../../util/alloc.hpp"
+
+using namespace cocaine;
+using namespace cocaine::framework;
+
+using namespace testing;
+
+TEST(UniqueFunction, AcceptsMoveOnlyCallable) {
+    std::unique_ptr<int> value(new int(42));
+
+    struct callable_t {
+        std::unique_ptr<int> value;
+
+        int
+        operator()() {
+            return *value;
+        }
+    };
+
+    unique_function<int()> fn(callable_t{std::move(value)});
+    unique_function<int()> moved(std::move(fn));
+
+    EXPECT_FALSE(static_cast<bool>(fn));
+    EXPECT_EQ(42, moved());
+}
+
+TEST(UniqueFunction, StoresSmallCallableInline) {
+    auto state = std::make_shared<int>(0);
+
+    const auto before = util::allocations();
+    {
+        unique_function<void(int)> fn([state](int value) {
+            *state += value;
+        });
+
+        fn(1);
+        auto moved = std::move(fn);
+        moved(2);
+    }
+
+    EXPECT_EQ(0, util::allocations() - before);
+    EXPECT_EQ(3, *state);
+}
+
+TEST(UniqueFunction, StoresLargeCallableOnHeap) {
+    std::array<char, 2 * unique_function<void()>::capacity> payload;
+    payload.fill('x');
+
+    unique_function<char()> fn([payload]() -> char {
+        return payload.back();
+    });
+
+    auto moved = std::move(fn);
+    EXPECT_EQ('x', moved());
+}
+
+TEST(UniqueFunction, ThrowsWhenEmpty) {
+    unique_function<void()> fn;
+    EXPECT_THROW(fn(), std::bad_function_call);
+}
+
+TEST(UniqueFunction, PassesContinuationsToDefaultExecutor) {
+    std::vector<unique_function<void()>> tasks;
+    executor_t executor = [&](unique_function<void()> task) {
+        tasks.push_back(std::move(task));
+    };
+
+    promise<int> pr;
+    auto source = pr.get_future();
+    source.set_default_executor(executor);
+
+    auto fr = source.then([](future<int>& fr) {
+        return fr.get() + 1;
+    });
+
+    pr.set_value(42);
+    ASSERT_EQ(1, tasks.size());
+    EXPECT_FALSE(fr.ready());
+
+    tasks.front()();
+    EXPECT_EQ(43, fr.get());
+}
+
+TEST(UniqueFunction, CallsContinuationsInlineDespiteExecutorGiven) {
+    std::vector<unique_function<void()>> tasks;
+    executor_t executor = [&](unique_function<void()> task) {
+        tasks.push_back(std::move(task));
+    };
+
+    promise<int> pr;
+    auto fr = pr.get_future().then(executor, [](future<int>& fr) {
+        return fr.get() + 1;
+    });
+
+    pr.set_value(42);
+    EXPECT_TRUE(tasks.empty());
+    ASSERT_TRUE(fr.ready());
+    EXPECT_EQ(43, fr.get());
+}
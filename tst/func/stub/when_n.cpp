@@ -0,0 +1,74 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/framework/forwards.hpp>
+#include <cocaine/framework/util/future/utility.hpp>
+
+using namespace cocaine;
+using namespace cocaine::framework;
+
+using namespace testing;
+
+TEST(WhenN, BecomesReadyOnQuorum) {
+    std::vector<promise<int>> promises(3);
+
+    std::vector<future<int>> futures;
+    for (auto& pr : promises) {
+        futures.emplace_back(pr.get_future());
+    }
+
+    auto result = when_n(futures, 2);
+
+    promises[2].set_value(3);
+    EXPECT_FALSE(result.ready());
+
+    promises[0].set_value(1);
+    ASSERT_TRUE(result.ready());
+
+    // All futures are returned in their original order, the one left is still pending.
+    auto ready = result.get();
+    ASSERT_EQ(3, ready.size());
+    EXPECT_EQ(1, ready[0].get());
+    EXPECT_FALSE(ready[1].ready());
+    EXPECT_EQ(3, ready[2].get());
+
+    promises[1].set_value(2);
+    EXPECT_EQ(2, ready[1].get());
+}
+
+TEST(WhenN, DetachesFromPendingFutures) {
+    std::vector<promise<int>> promises(2);
+
+    std::vector<future<int>> futures;
+    for (auto& pr : promises) {
+        futures.emplace_back(pr.get_future());
+    }
+
+    auto ready = when_any(futures);
+    promises[0].set_value(1);
+
+    auto result = ready.get();
+
+    // The pending future must accept its own continuation, which is called exactly once.
+    int calls = 0;
+    auto next = result[1].then([&](future<int>& fr) {
+        ++calls;
+        return fr.get() + 1;
+    });
+
+    promises[1].set_value(2);
+
+    EXPECT_EQ(1, calls);
+    EXPECT_EQ(3, next.get());
+}
+
+TEST(WhenN, AcceptsReadyFutures) {
+    std::vector<future<int>> futures;
+    futures.emplace_back(make_ready_future<int>::value(1));
+    futures.emplace_back(make_ready_future<int>::value(2));
+
+    auto result = when_all(futures);
+    ASSERT_TRUE(result.ready());
+    EXPECT_EQ(2, result.get()[1].get());
+}
@@ -0,0 +1,62 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/common.hpp>
+#include <cocaine/errors.hpp>
+#include <cocaine/idl/streaming.hpp>
+#include <cocaine/rpc/asio/encoder.hpp>
+
+#include <cocaine/framework/message.hpp>
+
+#include <cocaine/framework/detail/decoder.hpp>
+#include <cocaine/framework/detail/slab.hpp>
+
+#include "../config.hpp"
+
+using namespace cocaine;
+using namespace cocaine::framework;
+
+using namespace testing;
+using namespace testing::load;
+
+/// Feeds a single large chunk frame to the decoder in small pieces, the same way the reader does
+/// when the frame arrives in many TCP segments.
+TEST(load, decoder_chunk) {
+    uint size  = 64 * 1024 * 1024;
+    uint piece = 4 * 1024;
+    load_config("load.decoder.chunk", size, piece);
+
+    const auto frame = io::encoded<io::streaming<std::string>::chunk>(1, std::string(size, 'x'));
+
+    auto slab = detail::slab_t::acquire(frame.size());
+    std::memcpy(slab->data(), frame.data(), frame.size());
+
+    detail::decoder_t decoder;
+    decoded_message message(boost::none);
+
+    std::size_t calls = 0;
+    std::error_code ec;
+
+    const auto now = std::chrono::high_resolution_clock::now();
+    for (std::size_t received = 0; received < frame.size();) {
+        received = std::min<std::size_t>(received + piece, frame.size());
+
+        ec = std::error_code();
+        decoder.decode(slab, slab->data(), received, message, ec);
+        ++calls;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - now
+    ).count();
+
+    EXPECT_EQ(std::error_code(), ec);
+    EXPECT_EQ(1, message.span());
+
+    std::cout << frame.size() << " bytes in " << calls << " pieces, "
+              << elapsed << " us, "
+              << static_cast<double>(elapsed) / calls << " us per piece" << std::endl;
+}
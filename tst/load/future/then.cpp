@@ -0,0 +1,130 @@
+#include <chrono>
+#include <vector>
+#include <iostream>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/framework/forwards.hpp>
+
+#include "../config.hpp"
+#include "../../util/alloc.hpp"
+
+using namespace cocaine;
+using namespace cocaine::framework;
+
+using namespace testing;
+using namespace testing::load;
+
+namespace testing { namespace load { namespace future { namespace then {
+
+/// Attaches a continuation to each of the given number of pending futures, then fulfils them.
+///
+/// Both the continuation attaching and the value setting go through the shared state, which is
+/// the usual path of each hop in a continuation chain.
+auto
+run(std::size_t iters) -> std::uint64_t {
+    std::uint64_t sum = 0;
+
+    const auto now = std::chrono::high_resolution_clock::now();
+    for (std::size_t id = 0; id < iters; ++id) {
+        promise<int> pr;
+        auto fr = pr.get_future().then([&](framework::future<int>& fr) {
+            sum += fr.get();
+        });
+
+        pr.set_value(1);
+        fr.get();
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - now
+    ).count();
+
+    std::cout << iters << " set_value + then pairs, "
+              << elapsed << " us, "
+              << 1000.0 * elapsed / iters << " ns per pair" << std::endl;
+
+    return sum;
+}
+
+/// Builds the given number of three stage chains: a plain continuation, which is called on a
+/// queued executor, a continuation returning another pending future and a final one, then
+/// fulfils and drains them.
+///
+/// Returns the number of heap allocations made per chain, including both promises.
+auto
+chain(std::size_t iters) -> double {
+    std::vector<unique_function<void()>> queue;
+    queue.reserve(16);
+
+    executor_t executor = [&](unique_function<void()> fn) {
+        queue.push_back(std::move(fn));
+    };
+
+    auto drain = [&] {
+        for (std::size_t id = 0; id < queue.size(); ++id) {
+            auto fn = std::move(queue[id]);
+            fn();
+        }
+        queue.clear();
+    };
+
+    std::uint64_t sum = 0;
+
+    const auto before = util::allocations();
+    const auto now = std::chrono::high_resolution_clock::now();
+    for (std::size_t id = 0; id < iters; ++id) {
+        promise<int> pr;
+        promise<int> inner;
+
+        auto source = pr.get_future();
+        source.set_default_executor(executor);
+
+        auto fr = source.then([](framework::future<int>& fr) {
+            return fr.get() + 1;
+        }).then([&](framework::future<int>& fr) {
+            fr.get();
+            return inner.get_future();
+        }).then([&](framework::future<int>& fr) {
+            sum += fr.get();
+        });
+
+        pr.set_value(0);
+        drain();
+        inner.set_value(1);
+        drain();
+        fr.get();
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - now
+    ).count();
+    const auto allocations = static_cast<double>(util::allocations() - before) / iters;
+
+    std::cout << iters << " three stage chains, "
+              << elapsed << " us, "
+              << 1000.0 * elapsed / iters << " ns per chain, "
+              << allocations << " allocations per chain" << std::endl;
+
+    EXPECT_EQ(iters, sum);
+
+    return allocations;
+}
+
+}}}} // namespace testing::load::future::then
+
+TEST(load, future_then) {
+    uint iters = 1000000;
+    load_config("load.future.then", iters);
+
+    EXPECT_EQ(iters, load::future::then::run(iters));
+}
+
+TEST(load, future_chain) {
+    uint iters = 100000;
+    load_config("load.future.chain", iters);
+
+    // Two promises plus one state per stage: a continuation returning a future forwards into its
+    // own state and the executor hop is folded into the continuation object.
+    EXPECT_GE(5.0, load::future::then::chain(iters));
+}
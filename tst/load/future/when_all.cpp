@@ -0,0 +1,78 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/framework/forwards.hpp>
+#include <cocaine/framework/util/future/utility.hpp>
+
+#include "../config.hpp"
+#include "../../util/alloc.hpp"
+
+using namespace cocaine;
+using namespace cocaine::framework;
+
+using namespace testing;
+using namespace testing::load;
+
+namespace testing { namespace load { namespace future { namespace when_all {
+
+/// Aggregates the given number of futures, which are fulfilled from another thread, waiting for
+/// the given quorum of them.
+///
+/// Returns the number of ready futures in the result.
+auto
+run(std::size_t iters, std::size_t quorum) -> std::size_t {
+    std::vector<promise<int>> promises(iters);
+    std::vector<framework::future<int>> futures;
+    futures.reserve(iters);
+    for (auto& promise : promises) {
+        futures.emplace_back(promise.get_future());
+    }
+
+    const auto before = util::allocations();
+    const auto now = std::chrono::high_resolution_clock::now();
+
+    auto result = when_n(futures, quorum);
+
+    std::thread thread([&] {
+        for (auto& promise : promises) {
+            promise.set_value(42);
+        }
+    });
+
+    auto ready = result.get();
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - now
+    ).count();
+    const auto allocations = util::allocations() - before;
+
+    std::size_t count = 0;
+    for (auto& future : ready) {
+        if (future.ready()) {
+            EXPECT_EQ(42, future.get());
+            ++count;
+        }
+    }
+
+    thread.join();
+
+    std::cout << "quorum " << quorum << " of " << iters << " futures, "
+              << elapsed << " us, "
+              << allocations << " allocations" << std::endl;
+
+    return count;
+}
+
+}}}} // namespace testing::load::future::when_all
+
+TEST(load, future_when_all) {
+    uint iters = 20000;
+    load_config("load.future.when_all", iters);
+
+    EXPECT_EQ(iters, load::future::when_all::run(iters, iters));
+    EXPECT_LE(iters / 2, load::future::when_all::run(iters, iters / 2));
+    EXPECT_LE(1, load::future::when_all::run(iters, 1));
+}
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/common.hpp>
+#include <cocaine/idl/storage.hpp>
+#include <cocaine/traits/error_code.hpp>
+
+#include <cocaine/framework/service.hpp>
+#include <cocaine/framework/manager.hpp>
+
+#include "../config.hpp"
+
+namespace ph = std::placeholders;
+
+using namespace cocaine;
+using namespace cocaine::framework;
+
+using namespace testing;
+using namespace testing::load;
+
+namespace testing { namespace load { namespace service { namespace pool {
+
+void
+on_invoke(task<std::string>::future_move_type future) {
+    future.get();
+}
+
+/// Performs the given number of storage reads through the given number of pooled connections.
+void
+run(service_manager_t& manager, std::size_t iters, std::size_t connections) {
+    auto storage = manager.create<cocaine::io::storage_tag>("storage");
+    storage.pool(connections);
+    storage.connect().get();
+
+    const auto now = std::chrono::high_resolution_clock::now();
+
+    std::vector<task<void>::future_type> futures;
+    futures.reserve(iters);
+
+    for (std::size_t id = 0; id < iters; ++id) {
+        futures.emplace_back(
+            storage.invoke<io::storage::read>("collection", "key")
+                .then(std::bind(&load::service::pool::on_invoke, ph::_1))
+        );
+    }
+
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::high_resolution_clock::now() - now
+    ).count();
+
+    std::cout << connections << " connection(s): "
+              << iters << " invocations, "
+              << elapsed << " ms, "
+              << 1000.0 * iters / std::max<decltype(elapsed)>(elapsed, 1) << " RPS" << std::endl;
+}
+
+}}}} // namespace testing::load::service::pool
+
+TEST(load, service_pool) {
+    uint iters = 10000;
+    uint connections = 4;
+    load_config("load.service.pool", iters, connections);
+
+    service_manager_t manager;
+
+    load::service::pool::run(manager, iters, 1);
+    load::service::pool::run(manager, iters, connections);
+}
@@ -0,0 +1,97 @@
+#include <chrono>
+#include <iostream>
+
+#include <boost/thread/thread.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/common.hpp>
+#include <cocaine/idl/locator.hpp>
+
+#include <cocaine/framework/detail/basic_session.hpp>
+
+#include "../config.hpp"
+#include "loopback.hpp"
+
+using namespace cocaine;
+using namespace cocaine::framework;
+
+using namespace testing;
+using namespace testing::load;
+
+namespace testing { namespace load { namespace session { namespace invoke {
+
+auto
+size(std::uint64_t span) -> std::size_t {
+    detail::buffer_t buffer;
+    detail::encode<io::locator::resolve>(buffer, span, std::string("node"));
+    return buffer.size();
+}
+
+/// Performs the given number of invocations, evenly distributed between the given number of
+/// threads sharing the same session.
+void
+run(std::size_t iters, std::size_t concurrency) {
+    std::size_t expected = 0;
+    for (std::size_t span = 1; span <= iters; ++span) {
+        expected += size(span);
+    }
+
+    sink_t sink(expected);
+    client_t client;
+
+    auto session = std::make_shared<basic_session_t>(client.scheduler);
+    EXPECT_EQ(std::error_code(), session->connect(basic_session_t::endpoint_type(
+        boost::asio::ip::address_v4::loopback(), sink.endpoint().port()
+    )).get());
+
+    const auto now = std::chrono::high_resolution_clock::now();
+
+    std::vector<boost::thread> threads;
+    for (std::size_t id = 0; id < concurrency; ++id) {
+        threads.emplace_back([&, id] {
+            const std::size_t count = iters / concurrency + (id < iters % concurrency ? 1 : 0);
+
+            const std::string name("node");
+            const auto args = std::tie(name);
+
+            std::vector<future<basic_session_t::invoke_result>> futures;
+            futures.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                futures.emplace_back(session->invoke(encode_ref_t::make<io::locator::resolve>(args)));
+            }
+
+            for (auto& future : futures) {
+                future.get();
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    sink.join();
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::high_resolution_clock::now() - now
+    ).count();
+
+    std::cout << concurrency << " thread(s): "
+              << iters << " invocations, "
+              << elapsed << " ms, "
+              << 1000.0 * iters / std::max<decltype(elapsed)>(elapsed, 1) << " RPS" << std::endl;
+
+    session->cancel();
+}
+
+}}}} // namespace testing::load::session::invoke
+
+TEST(load, session_invoke) {
+    uint iters = 100000;
+    load_config("load.session.invoke", iters);
+
+    for (std::size_t concurrency : { 1, 2, 4, 8 }) {
+        load::session::invoke::run(iters, concurrency);
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <boost/optional/optional.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <asio/ip/tcp.hpp>
+
+#include <cocaine/framework/scheduler.hpp>
+
+#include <cocaine/framework/detail/loop.hpp>
+
+namespace testing { namespace load { namespace session {
+
+/// Loopback peer, which accepts a single connection and drains the given number of bytes, counting
+/// how many reads it took.
+class sink_t {
+    cocaine::framework::detail::loop_t loop;
+    asio::ip::tcp::acceptor acceptor;
+    boost::thread thread;
+
+public:
+    std::size_t reads;
+
+    explicit sink_t(std::size_t expected) :
+        acceptor(loop, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), 0)),
+        reads(0)
+    {
+        thread = boost::thread([this, expected] {
+            asio::ip::tcp::socket socket(loop);
+            acceptor.accept(socket);
+
+            std::vector<char> buffer(64 * 1024);
+            for (std::size_t received = 0; received < expected; ++reads) {
+                received += socket.read_some(asio::buffer(buffer));
+            }
+        });
+    }
+
+    ~sink_t() {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    asio::ip::tcp::endpoint
+    endpoint() const {
+        return asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), acceptor.local_endpoint().port());
+    }
+
+    void
+    join() {
+        thread.join();
+    }
+};
+
+/// Client side event loop, running in its own thread.
+class client_t {
+    cocaine::framework::detail::loop_t io;
+    boost::optional<cocaine::framework::detail::loop_t::work> work;
+    cocaine::framework::event_loop_t loop;
+    boost::thread thread;
+
+public:
+    cocaine::framework::scheduler_t scheduler;
+
+    client_t() :
+        work(cocaine::framework::detail::loop_t::work(io)),
+        loop(io),
+        thread([this] { io.run(); }),
+        scheduler(loop)
+    {}
+
+    ~client_t() {
+        work.reset();
+        thread.join();
+    }
+};
+
+}}} // namespace testing::load::session
@@ -0,0 +1,86 @@
+#include <chrono>
+#include <iostream>
+
+#include <gtest/gtest.h>
+
+#include <cocaine/common.hpp>
+#include <cocaine/idl/locator.hpp>
+
+#include <cocaine/framework/detail/basic_session.hpp>
+
+#include "../config.hpp"
+#include "loopback.hpp"
+
+using namespace cocaine;
+using namespace cocaine::framework;
+
+using namespace testing;
+using namespace testing::load;
+
+namespace testing { namespace load { namespace session { namespace push {
+
+auto
+message(std::uint64_t span) -> io::encoder_t::message_type {
+    return io::encoded<io::locator::resolve>(span, std::string("node"));
+}
+
+/// Pushes the given number of messages and returns the number of reads the peer required to
+/// receive all of them.
+///
+/// If the burst flag is not set, each push waits for the previous one to complete, which is
+/// equivalent to the one-write-per-message behavior.
+auto
+run(std::size_t iters, bool burst) -> std::size_t {
+    sink_t sink(iters * message(1).size());
+    client_t client;
+
+    auto session = std::make_shared<basic_session_t>(client.scheduler);
+    EXPECT_EQ(std::error_code(), session->connect(basic_session_t::endpoint_type(
+        boost::asio::ip::address_v4::loopback(), sink.endpoint().port()
+    )).get());
+
+    std::vector<future<void>> futures;
+    futures.reserve(iters);
+
+    const auto now = std::chrono::high_resolution_clock::now();
+    for (std::size_t id = 0; id < iters; ++id) {
+        futures.emplace_back(session->push(message(id + 1)));
+
+        if (!burst) {
+            futures.back().get();
+            futures.pop_back();
+        }
+    }
+
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    sink.join();
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::high_resolution_clock::now() - now
+    ).count();
+
+    std::cout << (burst ? "coalesced: " : "sequential: ")
+              << iters << " messages, "
+              << sink.reads << " reads, "
+              << static_cast<double>(iters) / sink.reads << " messages per read, "
+              << elapsed << " ms" << std::endl;
+
+    session->cancel();
+
+    return sink.reads;
+}
+
+}}}} // namespace testing::load::session::push
+
+TEST(load, session_push) {
+    uint iters = 10000;
+    load_config("load.session.push", iters);
+
+    const auto sequential = load::session::push::run(iters, false);
+    const auto coalesced  = load::session::push::run(iters, true);
+
+    EXPECT_LE(coalesced, sequential);
+}
@@ -0,0 +1,73 @@
+#include "alloc.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<std::uint64_t> counter(0);
+
+void* allocate(std::size_t size) {
+#if !defined(__GLIBC__)
+    counter.fetch_add(1, std::memory_order_relaxed);
+#endif
+
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+std::uint64_t testing::util::allocations() {
+    return counter.load(std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+
+// The C allocation functions are replaced too, because msgpack zones and other C-style code
+// allocate their memory directly with malloc. Operator new is built on top of them, so each
+// allocation is counted exactly once.
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+
+void* malloc(std::size_t size) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, std::size_t size) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+
+#endif
+
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
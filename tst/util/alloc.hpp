@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+namespace testing {
+
+namespace util {
+
+/// Returns the number of heap allocations made by the test binary so far.
+///
+/// The counter is maintained by the replaced global allocation functions, so it covers the whole
+/// test suite. On glibc the C allocation functions are replaced as well, so memory allocated with
+/// malloc directly, like msgpack zone chunks, is counted too.
+std::uint64_t allocations();
+
+} // namespace util
+
+} // namespace testing
@@ -0,0 +1,102 @@
+#include "stub.hpp"
+
+#include <cstring>
+#include <future>
+
+#include <cocaine/framework/detail/decoder.hpp>
+#include <cocaine/framework/detail/slab.hpp>
+
+using namespace cocaine::framework;
+using namespace cocaine::framework::detail;
+
+using namespace testing::util;
+
+stub_t::stub_t(handler_type handler) :
+    handler(std::move(handler)),
+    loop(nullptr),
+    acceptor(nullptr),
+    port(util::port()),
+    connections(0)
+{
+    server.reset(new server_t(port, [&](asio::ip::tcp::acceptor& acceptor, loop_t& loop) {
+        this->acceptor = &acceptor;
+        this->loop = &loop;
+        accept();
+        loop.run();
+    }));
+}
+
+stub_t::~stub_t() {
+    loop.load()->stop();
+    server.reset();
+}
+
+auto stub_t::endpoint() const -> boost::asio::ip::tcp::endpoint {
+    return boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), port);
+}
+
+void stub_t::post(std::function<void()> fn) {
+    loop.load()->post(std::move(fn));
+}
+
+void stub_t::refuse() {
+    std::promise<void> closed;
+
+    post([&] {
+        std::error_code ec;
+        acceptor->close(ec);
+        closed.set_value();
+    });
+
+    closed.get_future().wait();
+}
+
+void stub_t::accept() {
+    auto connection = std::make_shared<connection_t>(*loop.load());
+
+    acceptor->async_accept(connection->socket, [&, connection](const std::error_code& ec) {
+        if (ec) {
+            return;
+        }
+
+        ++connections;
+        read(connection);
+        accept();
+    });
+}
+
+void stub_t::read(std::shared_ptr<connection_t> connection) {
+    connection->socket.async_read_some(asio::buffer(connection->buffer),
+        [&, connection](const std::error_code& ec, std::size_t size)
+    {
+        if (ec) {
+            return;
+        }
+
+        connection->pending.append(connection->buffer.data(), size);
+
+        auto slab = slab_t::acquire(connection->pending.size());
+        std::memcpy(slab->data(), connection->pending.data(), connection->pending.size());
+
+        decoder_t decoder;
+        std::size_t offset = 0;
+        for (;;) {
+            decoded_message message(boost::none);
+
+            std::error_code ec;
+            offset += decoder.decode(slab, slab->data() + offset, connection->pending.size() - offset, message, ec);
+            if (ec) {
+                break;
+            }
+
+            handler(connection, message);
+
+            if (!connection->socket.is_open()) {
+                return;
+            }
+        }
+
+        connection->pending.erase(0, offset);
+        read(connection);
+    });
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <boost/asio/ip/tcp.hpp>
+
+#include <asio/ip/tcp.hpp>
+#include <asio/write.hpp>
+
+#include <cocaine/rpc/asio/encoder.hpp>
+
+#include <cocaine/framework/message.hpp>
+
+#include "net.hpp"
+
+namespace testing {
+
+namespace util {
+
+/// Stub server, which decodes messages received through each connection accepted and passes them
+/// to the given handler.
+///
+/// Both the handler and the closures posted are called on the server thread. The handler may
+/// close the connection, in which case messages left in it are dropped.
+class stub_t {
+public:
+    struct connection_t {
+        asio::ip::tcp::socket socket;
+        std::array<char, 4096> buffer;
+        std::string pending;
+
+        explicit
+        connection_t(fw::detail::loop_t& loop) :
+            socket(loop)
+        {}
+
+        template<class Event, class... Args>
+        void
+        send(std::uint64_t span, Args&&... args) {
+            const auto message = cocaine::io::encoded<Event>(span, std::forward<Args>(args)...);
+
+            std::error_code ec;
+            asio::write(socket, asio::buffer(message.data(), message.size()), ec);
+        }
+    };
+
+    typedef std::function<void(const std::shared_ptr<connection_t>&, const fw::decoded_message&)> handler_type;
+
+private:
+    handler_type handler;
+    std::atomic<fw::detail::loop_t*> loop;
+    asio::ip::tcp::acceptor* acceptor;
+    std::unique_ptr<server_t> server;
+
+public:
+    const std::uint16_t port;
+
+    std::atomic<unsigned int> connections;
+
+    explicit
+    stub_t(handler_type handler);
+
+    ~stub_t();
+
+    auto
+    endpoint() const -> boost::asio::ip::tcp::endpoint;
+
+    void
+    post(std::function<void()> fn);
+
+    /// Stops accepting connections, so that new ones are refused, while keeping ones accepted.
+    void
+    refuse();
+
+private:
+    void
+    accept();
+
+    void
+    read(std::shared_ptr<connection_t> connection);
+};
+
+/// Waits until the given condition holds, giving up after the test timeout.
+template<class F>
+bool
+eventually(F condition) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TIMEOUT);
+
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return true;
+}
+
+} // namespace util
+
+} // namespace testing